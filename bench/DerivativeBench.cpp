@@ -0,0 +1,247 @@
+#include <Geodesics.h>
+#include <omp.h>
+
+/*
+ * Derivative-kernel microbenchmarks: every derivative path of the BSSN RHS
+ * timed on its own over an N^3 grid of smooth data, for the FD_ORDER and
+ * layout this binary was built with (make bench builds one binary per
+ * variant). Each kernel reports ns per point, bandwidth from its
+ * compulsory traffic (fields read once, results written once) and FLOP
+ * rate from its nominal per-point operation count, and the whole run is
+ * written as JSON.
+ *
+ * usage: derivative_bench [N] [report.json]
+ */
+
+float (*geodesic_points)[5] = NULL;
+int num_points = 0;
+float a = 0.0;
+
+#define BENCH_REPS 5
+
+struct BenchResult {
+	const char *name;
+	double seconds;		/* best of BENCH_REPS */
+	double bytes;		/* per point */
+	double flops;		/* per point */
+};
+
+struct DerivativeBench {
+	/* best wall time of fn() over BENCH_REPS runs after one warm-up */
+	template <typename Fn>
+	static double best_of(Fn &&fn) {
+		fn();
+		double best = 1e30;
+		for (int r = 0; r < BENCH_REPS; r++) {
+			auto t0 = std::chrono::high_resolution_clock::now();
+			fn();
+			auto t1 = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+		}
+		return best;
+	}
+
+	/* smooth non-trivial data on the physical points, ghosts by fill_ghosts() */
+	static void fill(Grid &g) {
+		#pragma omp parallel for collapse(2)
+		for (int i = 0; i < g.nx; i++)
+			for (int j = 0; j < g.ny; j++)
+				for (int k = 0; k < g.nz; k++) {
+					const float x = i * g.dx, y = j * g.dy, z = k * g.dz;
+					const float s = sinf(0.7f * x + 0.3f * y) * cosf(0.5f * z);
+					for (int f = 0; f < NUM_FIELDS; f++)
+						g.at(Field(f), i, j, k) = 0.1f * s * (1.0f + 0.05f * f);
+					g.at(F_ALPHA, i, j, k) += 1.0f;
+					g.at(F_CHI, i, j, k) += 1.0f;
+					for (int c : { 0, 3, 5 })
+						g.at(Field(F_GTXX + c), i, j, k) += 1.0f;
+					Grid::Cell2D &cell = g.getCell(i, j, k);
+					for (int c = 0; c < SYM_NCOMP; c++)
+						cell.geom.tildgamma_inv[c] = (c == 0 || c == 3 || c == 5) ? 1.0f : 0.0f;
+				}
+		#pragma omp parallel
+		g.fill_ghosts();
+	}
+
+	template <typename D>
+	static std::vector<BenchResult> run(Grid &g) {
+		constexpr int R = FD::R;
+		const int nx = D::nx(g), ny = D::ny(g), nz = D::nz(g);
+		std::vector<BenchResult> res;
+		auto add = [&](const char *name, double bytes, double flops, auto &&fn) {
+			res.push_back({ name, best_of(fn), bytes, flops });
+		};
+
+		/* nominal FLOPs per point of one stencil application */
+		const double d1_flops = 3.0 * R;
+		const double d2_flops = 3.0 * R + 2.0;
+		const double mixed_flops = R * (5.0 * R + 2.0) + 2.0;
+		const double hess_flops = 3.0 * d2_flops + 3.0 * mixed_flops;
+		const double adv_flops = 3.0 * (2.0 * 2.0 * (2 * R + 1) + 3.0);
+
+		const float *u = g.storage.fields[F_ALPHA];
+		float **d = g.dcache.d[0];
+		float *const hess[SYM_NCOMP] = { d[0], d[1], d[2], d[3], d[4], d[5] };
+		float *out3[3] = { g.dcache.d[0][0], g.dcache.d[1][0], g.dcache.d[2][0] };
+		const float *const beta[3] = { g.storage.fields[F_BETA0], g.storage.fields[F_BETA1],
+		                               g.storage.fields[F_BETA2] };
+
+		/* the fixed fourth-order helper reaches 2 points, past GHOST at ORDER=2 UPWIND=0 */
+#if GHOST >= 2
+		add("fourth_order_diff", 16, 3 * 7.0, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				for (int m = 0; m < 3; m++)
+					for (int k = kb; k < ke; k++) {
+						auto at = [&](int s) { return u[shifted_offset<D>(g, i, j, k, m, s)]; };
+						const float h = m == 0 ? g.dx : m == 1 ? g.dy : g.dz;
+						out3[m][D::offset(g, i, j, k)] = fourth_order_diff(at(2), at(1), at(-1), at(-2), h);
+					}
+			});
+		});
+#endif
+		add("partial_m", 16, 3 * d1_flops, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				for (int m = 0; m < 3; m++)
+					for (int k = kb; k < ke; k++)
+						out3[m][D::offset(g, i, j, k)] = partial_m<D>(g, i, j, k, m, F_ALPHA);
+			});
+		});
+		add("pencil_d1", 16, 3 * d1_flops, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				for (int m = 0; m < 3; m++)
+					pencil_d1<D>(g, u, m, i, j, kb, ke, out3[m]);
+			});
+		});
+		add("second_partial", 28, hess_flops, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				for (int c = 0; c < SYM_NCOMP; c++)
+					for (int k = kb; k < ke; k++)
+						hess[c][D::offset(g, i, j, k)] = second_partial<D>(g, i, j, k, SYM_A[c], SYM_B[c], F_ALPHA);
+			});
+		});
+		add("pencil_hessian", 28, hess_flops, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				pencil_hessian<D>(g, u, i, j, kb, ke, hess);
+			});
+		});
+		add("pencil_advect", 20, adv_flops, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				pencil_advect<D>(g, u, beta, i, j, kb, ke, out3[0]);
+			});
+		});
+
+		/* the whole per-stage pass, then kernels reading the valid cache */
+		const double cache_bytes = 4.0 * (F_KXX + Grid::DerivativeCache::NARRAYS);
+		const double cache_flops = NUM_DERIV_FIELDS * 3 * d1_flops + NUM_HESS_FIELDS * hess_flops
+		                         + NUM_ADV_FIELDS * adv_flops;
+		add("fill_derivative_cache", cache_bytes, cache_flops, [&] {
+			#pragma omp parallel
+			g.fill_derivative_cache<D>();
+		});
+#if GRID_COMPACT
+		add("fill_compact_derivatives", 4.0 * 4 * NUM_DERIV_FIELDS, NUM_DERIV_FIELDS * 3 * 11.0, [&] {
+			#pragma omp parallel
+			g.fill_compact_derivatives<D>();
+		});
+#endif
+		#pragma omp parallel
+		g.fill_derivative_cache<D>();
+
+		/*
+		 * The Christoffel kernels write their results into the Hessian and
+		 * advection arrays of the cache, which neither of them reads: the 18
+		 * independent Gamma^m_ab and the divergence d_m Gamma^m_ab.
+		 */
+		static_assert(NUM_HESS_FIELDS == 2 && NUM_ADV_FIELDS >= 2 * SYM_NCOMP, "Christoffel sinks overflow the cache");
+		float *christ[3 * SYM_NCOMP], *div[SYM_NCOMP];
+		for (int c = 0; c < SYM_NCOMP; c++) {
+			christ[c] = g.dcache.dd[0][c];
+			christ[SYM_NCOMP + c] = g.dcache.dd[1][c];
+			christ[2 * SYM_NCOMP + c] = g.dcache.adv[c];
+			div[c] = g.dcache.adv[SYM_NCOMP + c];
+		}
+		GridTensor gt;
+		add("compute_christoffel_3D", 4.0 * (18 + 6 + 27 + 18), 27 * 12.0 + 27, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				float christof[3][3][3];
+				for (int k = kb; k < ke; k++) {
+					gt.compute_christoffel_3D<D>(g, i, j, k, christof);
+					const size_t o = D::offset(g, i, j, k);
+					for (int m = 0; m < 3; m++)
+						for (int c = 0; c < SYM_NCOMP; c++)
+							christ[m * SYM_NCOMP + c][o] = christof[m][SYM_A[c]][SYM_B[c]];
+				}
+			});
+		});
+		add("compute_partial_christoffel", 4.0 * (27 + 6), 3 * 27 * 3.0 + 2 * SYM_NCOMP, [&] {
+			#pragma omp parallel
+			for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+				float dG[3][3][3][3];
+				for (int k = kb; k < ke; k++) {
+					for (int m = 0; m < 3; m++)
+						gt.compute_partial_christoffel(g, i, j, k, m, dG, m == 0 ? g.dx : m == 1 ? g.dy : g.dz);
+					const size_t o = D::offset(g, i, j, k);
+					for (int c = 0; c < SYM_NCOMP; c++)
+						div[c][o] = dG[0][0][SYM_A[c]][SYM_B[c]] + dG[1][1][SYM_A[c]][SYM_B[c]]
+						          + dG[2][2][SYM_A[c]][SYM_B[c]];
+				}
+			});
+		});
+		g.dcache.valid = false;
+		return res;
+	}
+
+	static int main(int n, const char *json) {
+		Grid g(n, n, n, DX_DEFAULT, DY_DEFAULT, DZ_DEFAULT);
+		g.allocateGlobalGrid();
+		g.dcache.allocate(g.storage.size(), GRID_HUGEPAGES);
+		fill(g);
+
+		std::vector<BenchResult> res;
+		const int fixed = dispatch_dims(g, [&](auto dims) { res = run<decltype(dims)>(g); });
+		const double npts = static_cast<double>(n) * n * n;
+
+		printf("%-28s %10s %10s %10s\n", "kernel", "ns/point", "GB/s", "GFLOP/s");
+		for (const auto &r : res)
+			printf("%-28s %10.3f %10.2f %10.2f\n", r.name, 1e9 * r.seconds / npts,
+			       r.bytes * npts / r.seconds * 1e-9, r.flops * npts / r.seconds * 1e-9);
+
+		FILE *fp = json ? fopen(json, "w") : NULL;
+		if (json && !fp) {
+			fprintf(stderr, "Failed to open %s\n", json);
+			return 1;
+		}
+		if (fp) {
+			fprintf(fp, "{\n  \"n\": %d, \"fd_order\": %d, \"ko_order\": %d, \"upwind\": %d,"
+			        " \"brick\": %d, \"compact\": %d, \"fixed_size\": %d, \"threads\": %d,"
+			        " \"reps\": %d,\n  \"kernels\": [\n",
+			        n, FD_ORDER, KO_ORDER, GRID_UPWIND, GRID_BRICK, GRID_COMPACT, fixed,
+			        omp_get_max_threads(), BENCH_REPS);
+			for (size_t r = 0; r < res.size(); r++)
+				fprintf(fp, "    { \"name\": \"%s\", \"seconds\": %.6e, \"ns_per_point\": %.4f,"
+				        " \"gb_per_s\": %.4f, \"gflop_per_s\": %.4f, \"bytes_per_point\": %.1f,"
+				        " \"flops_per_point\": %.1f }%s\n",
+				        res[r].name, res[r].seconds, 1e9 * res[r].seconds / npts,
+				        res[r].bytes * npts / res[r].seconds * 1e-9,
+				        res[r].flops * npts / res[r].seconds * 1e-9,
+				        res[r].bytes, res[r].flops, r + 1 < res.size() ? "," : "");
+			fprintf(fp, "  ]\n}\n");
+			fclose(fp);
+			printf("Report written to %s\n", json);
+		}
+		g.dcache.release();
+		return 0;
+	}
+};
+
+int main(int argc, char **argv) {
+	const int n = argc > 1 ? atoi(argv[1]) : 128;
+	return DerivativeBench::main(n, argc > 2 ? argv[2] : NULL);
+}
@@ -30,6 +30,232 @@ inline float second_order_diff(const T &plus1, const T &minus1, float dx)
 }
 
 
+/*
+ * Centred stencil weights, row R-1 for the order 2R scheme. FD_D1[.][s] is
+ * the weight of u[+s] - u[-s] in h u', FD_D2[.][0] the centre weight and
+ * FD_D2[.][s] the weight of u[+s] + u[-s] in h^2 u''.
+ */
+constexpr float FD_D1[4][5] = {
+	{ 0.0f, 1.0f / 2 },
+	{ 0.0f, 2.0f / 3, -1.0f / 12 },
+	{ 0.0f, 3.0f / 4, -3.0f / 20, 1.0f / 60 },
+	{ 0.0f, 4.0f / 5, -1.0f / 5, 4.0f / 105, -1.0f / 280 },
+};
+constexpr float FD_D2[4][5] = {
+	{ -2.0f, 1.0f },
+	{ -5.0f / 2, 4.0f / 3, -1.0f / 12 },
+	{ -49.0f / 18, 3.0f / 2, -3.0f / 20, 1.0f / 90 },
+	{ -205.0f / 72, 8.0f / 5, -1.0f / 5, 8.0f / 315, -1.0f / 560 },
+};
+
+/*
+ * Boundary closure: w[g-1][m] extrapolates the degree Q polynomial through
+ * the points 0..Q of a line to the ghost point -g (Lagrange weights at -g).
+ * Running the centred stencil over such ghosts is the same as switching to
+ * a one-sided stencil of order Q near the boundary.
+ */
+template <int R, int Q>
+struct FDClosure {
+	float w[R][Q + 1];
+};
+
+template <int R, int Q>
+constexpr FDClosure<R, Q> fd_closure() {
+	FDClosure<R, Q> c = {};
+	for (int g = 1; g <= R; g++) {
+		for (int m = 0; m <= Q; m++) {
+			double l = 1.0;
+			for (int n = 0; n <= Q; n++)
+				if (n != m)
+					l *= static_cast<double>(-g - n) / (m - n);
+			c.w[g - 1][m] = static_cast<float>(l);
+		}
+	}
+	return c;
+}
+
+/*
+ * Lopsided first derivative of order 2R on the 2R + 1 points -(R-1)..R+1:
+ * w[n] is the weight of u[n - R + 1], the derivative at 0 of the Lagrange
+ * polynomial through those points. R = 2 gives the usual
+ * (-3, -10, 18, -6, 1) / 12 advection stencil.
+ */
+template <int R>
+struct FDLopsided {
+	float w[2 * R + 1];
+};
+
+template <int R>
+constexpr FDLopsided<R> fd_lopsided() {
+	FDLopsided<R> c = {};
+	for (int m = 0; m <= 2 * R; m++) {
+		const double xm = m - R + 1;
+		double d = 0.0;
+		for (int l = 0; l <= 2 * R; l++) {
+			if (l == m)
+				continue;
+			double t = 1.0 / (xm - (l - R + 1));
+			for (int n = 0; n <= 2 * R; n++)
+				if (n != m && n != l)
+					t *= (0.0 - (n - R + 1)) / (xm - (n - R + 1));
+			d += t;
+		}
+		c.w[m] = static_cast<float>(d);
+	}
+	return c;
+}
+
+/*
+ * Finite differences of accuracy Order on any accessor: u(s) is the value
+ * s points along the axis, u(s, t) the value s along a and t along b. The
+ * centred stencils reach R = Order / 2 points each way, the lopsided
+ * advection stencil R + 1 when GRID_UPWIND is on; REACH is what GHOST
+ * pads. Boundary points use the same stencils over ghosts filled with the
+ * order Order - 1 closure, the usual one order drop at the boundary that
+ * keeps the global error at Order.
+ */
+template <int Order>
+struct FDStencil {
+	static constexpr int R = Order / 2;
+	static constexpr int Q = Order - 1;
+	static constexpr int REACH = R + GRID_UPWIND;
+	static constexpr FDClosure<REACH, Q> closure = fd_closure<REACH, Q>();
+	static constexpr FDLopsided<R> lopsided = fd_lopsided<R>();
+
+	template <typename At>
+	__attribute__((always_inline))
+	static inline float first(At u, float h) {
+		float s = 0.0f;
+		for (int m = R; m >= 1; m--)
+			s += FD_D1[R - 1][m] * (u(m) - u(-m));
+		return s / h;
+	}
+
+	template <typename At>
+	__attribute__((always_inline))
+	static inline float second(At u, float h) {
+		float s = 0.0f;
+		for (int m = R; m >= 1; m--)
+			s += FD_D2[R - 1][m] * (u(m) + u(-m));
+		return (s + FD_D2[R - 1][0] * u(0)) / (h * h);
+	}
+
+	/* d_a d_b for a != b: the tensor product of two first derivative stencils */
+	template <typename At2>
+	__attribute__((always_inline))
+	static inline float mixed(At2 u, float ha, float hb) {
+		float s = 0.0f;
+		for (int p = R; p >= 1; p--) {
+			float t = 0.0f;
+			for (int q = R; q >= 1; q--)
+				t += FD_D1[R - 1][q] * (u(p, q) - u(p, -q) - u(-p, q) + u(-p, -q));
+			s += FD_D1[R - 1][p] * t;
+		}
+		return s / (ha * hb);
+	}
+
+	/*
+	 * Advective derivative for a term b u': the lopsided stencil leaning
+	 * towards +axis when b > 0 and towards -axis otherwise (the side the
+	 * data comes from). Both are evaluated and one is selected, so a SIMD
+	 * loop over it compiles to a blend instead of a branch. Centred when
+	 * GRID_UPWIND is off.
+	 */
+	template <typename At>
+	__attribute__((always_inline))
+	static inline float upwind(At u, float b, float h) {
+#if GRID_UPWIND
+		float p = 0.0f, m = 0.0f;
+		for (int n = 0; n <= 2 * R; n++) {
+			p += lopsided.w[n] * u(n - R + 1);
+			m -= lopsided.w[n] * u(R - 1 - n);
+		}
+		return (b > 0.0f ? p : m) / h;
+#else
+		(void)b;
+		return first(u, h);
+#endif
+	}
+
+	/* value at ghost -g (1 <= g <= REACH) of a line whose point m is at(m) */
+	template <typename At>
+	static inline float extrapolate(At at, int g) {
+		float v = 0.0f;
+		for (int m = 0; m <= Q; m++)
+			v += closure.w[g - 1][m] * at(m);
+		return v;
+	}
+};
+
+using FD = FDStencil<FD_ORDER>;
+static_assert(FD::REACH == GHOST, "ghost layers must cover the stencil reach");
+
+constexpr double binomial(int n, int m) {
+	double b = 1.0;
+	for (int q = 1; q <= m; q++)
+		b = b * (n - m + q) / q;
+	return b;
+}
+
+/*
+ * Kreiss-Oliger dissipation of order Order = 2r along one axis,
+ * Q u = (-1)^(r+1) h^(2r-1) (D+ D-)^r u / 2^(2r), which damps the highest
+ * grid frequency and leaves smooth data alone to O(h^(2r-1)). w[m] is the
+ * weight of u[+m] and u[-m]; the stencil reaches r points, within GHOST.
+ */
+template <int Order>
+struct KOStencil {
+	static constexpr int R = Order / 2;
+
+	struct Weights {
+		float w[R + 1];
+	};
+	static constexpr Weights weights() {
+		Weights k = {};
+		for (int m = 0; m <= R; m++)
+			k.w[m] = static_cast<float>((m % 2 ? 1.0 : -1.0) * binomial(2 * R, R + m) / (1 << (2 * R)));
+		return k;
+	}
+	static constexpr Weights W = weights();
+
+	template <typename At>
+	__attribute__((always_inline))
+	static inline float apply(At u, float h) {
+		float s = W.w[0] * u(0);
+		for (int m = R; m >= 1; m--)
+			s += W.w[m] * (u(m) + u(-m));
+		return s / h;
+	}
+};
+
+using KO = KOStencil<KO_ORDER>;
+
+/* KO_SIGMA, or GRID_KO_SIGMA from the environment when set */
+float ko_dissipation_strength();
+
+/*
+ * Accessor s points from point p of a line of n points reached only
+ * through get(q), 0 <= q < n, i.e. data without ghost layers: points a
+ * stencil needs past either end are extrapolated with the FD closure.
+ */
+template <typename Get>
+inline auto line_closure(Get get, int p, int n) {
+	return [=](int s) {
+		const int q = p + s;
+		if (q < 0)
+			return FD::extrapolate([&](int m) { return get(m); }, -q);
+		if (q >= n)
+			return FD::extrapolate([&](int m) { return get(n - 1 - m); }, q - n + 1);
+		return get(q);
+	};
+}
+
+/* FD first derivative at point p of such a line */
+template <typename Get>
+inline float line_d1(Get get, int p, int n, float h) {
+	return FD::first(line_closure(get, p, n), h);
+}
+
 class Derivatives
 {
     public:
@@ -59,95 +285,328 @@ class Derivatives
 };
 
 
+#if GRID_SPECTRAL
+/* d_dim of one periodic N_x x N_y x N_z field, through SpectralDerivative */
 void spectral_derivative_3D(const std::vector<float> &f_in,
 				std::vector<float> &f_out,
 				int N_x, int N_y, int N_z,
 				float dx, float dy, float dz,
 				int dim);
+#endif
+
+/*
+ * d/dx along dim of a packed N_x x N_y x N_z field sampled on the
+ * chebyshev_nodes() of [a, b] along that axis; f_out may be f_in.
+ */
+void chebyshev_derivative_3D(const float *f_in, float *f_out,
+				int N_x, int N_y, int N_z,
+				float a, float b, int dim);
 
 
+/*
+ * Stencils on a per-cell quantity picked by f from Cell2D. Cells carry no
+ * ghost layers, so the line ends go through the FD closure in line_d1().
+ */
 template <typename Func>
 float partialX(Grid &grid_obj, int i, int j, int k, Func f) {
-	if (i < 0 || i >= NX) return 0.0;
-	if (j < 0 || j >= NY) return 0.0;
-	if (k < 0 || k >= NZ) return 0.0;
-	if (i >= 2 && i <= NX - 3) {
-		return fourth_order_diff(
-				f(grid_obj.getCell(i+2, j, k)),
-				f(grid_obj.getCell(i+1, j, k)),
-				f(grid_obj.getCell(i-1, j, k)),
-				f(grid_obj.getCell(i-2, j, k)),
-				DX
-				);
-	} else if (i >= 1 && i <= NX - 2) {
-		return second_order_diff(
-				f(grid_obj.getCell(i+1, j, k)),
-				f(grid_obj.getCell(i-1, j, k)),
-				DX
-				);
-	} else if (i == 0) {
-		return (f(grid_obj.getCell(i+1, j, k)) - f(grid_obj.getCell(i, j, k))) / DX;
-	} else if (i == NX - 1) {
-		return (f(grid_obj.getCell(i, j, k)) - f(grid_obj.getCell(i-1, j, k))) / DX;
-	}
-	return 0.0;
+	if (i < 0 || i >= grid_obj.nx) return 0.0;
+	if (j < 0 || j >= grid_obj.ny) return 0.0;
+	if (k < 0 || k >= grid_obj.nz) return 0.0;
+	return line_d1([&](int q) { return f(grid_obj.getCell(q, j, k)); }, i, grid_obj.nx, grid_obj.dx);
 }
 
-
 template <typename Func>
 float partialY(Grid &grid_obj, int i, int j, int k, Func f) {
-	if (j < 0 || j >= NY) return 0.0;
-	if (i < 0 || i >= NX) return 0.0;
-	if (k < 0 || k >= NZ) return 0.0;
-	if (j >= 2 && j <= NY - 3) {
-		return fourth_order_diff(
-				f(grid_obj.getCell(i, j+2, k)),
-				f(grid_obj.getCell(i, j+1, k)),
-			f(grid_obj.getCell(i, j-1, k)),
-			f(grid_obj.getCell(i, j-2, k)),
-			DY
-		);
-	} else if (j >= 1 && j <= NY - 2) {
-		return second_order_diff(
-			f(grid_obj.getCell(i, j+1, k)),
-			f(grid_obj.getCell(i, j-1, k)),
-			DY
-		);
-	} else if (j == 0) {
-		return (f(grid_obj.getCell(i, j+1, k)) - f(grid_obj.getCell(i, j, k))) / DY;
-	} else if (j == NY - 1) {
-		return (f(grid_obj.getCell(i, j, k)) - f(grid_obj.getCell(i, j-1, k))) / DY;
-	}
-	return 0.0;
+	if (j < 0 || j >= grid_obj.ny) return 0.0;
+	if (i < 0 || i >= grid_obj.nx) return 0.0;
+	if (k < 0 || k >= grid_obj.nz) return 0.0;
+	return line_d1([&](int q) { return f(grid_obj.getCell(i, q, k)); }, j, grid_obj.ny, grid_obj.dy);
 }
 
 template <typename Func>
 float partialZ(Grid &grid_obj, int i, int j, int k, Func f) {
-	if (k < 0 || k >= NZ) return 0.0;
-	if (i < 0 || i >= NX) return 0.0;
-	if (j < 0 || j >= NY) return 0.0;
-	if (k >= 2 && k <= NZ - 3) {
-		return fourth_order_diff(
-			f(grid_obj.getCell(i, j, k+2)),
-			f(grid_obj.getCell(i, j, k+1)),
-			f(grid_obj.getCell(i, j, k-1)),
-			f(grid_obj.getCell(i, j, k-2)),
-			DZ
-		);
-	} else if (k >= 1 && k <= NZ - 2) {
-		return second_order_diff(
-			f(grid_obj.getCell(i, j, k+1)),
-			f(grid_obj.getCell(i, j, k-1)),
-			DZ
-		);
-	} else if (k == 0) {
-		return (f(grid_obj.getCell(i, j, k+1)) - f(grid_obj.getCell(i, j, k))) / DZ;
-	} else if (k == NZ - 1) {
-		return (f(grid_obj.getCell(i, j, k)) - f(grid_obj.getCell(i, j, k-1))) / DZ;
-	}
-	return 0.0;
+	if (k < 0 || k >= grid_obj.nz) return 0.0;
+	if (i < 0 || i >= grid_obj.nx) return 0.0;
+	if (j < 0 || j >= grid_obj.ny) return 0.0;
+	return line_d1([&](int q) { return f(grid_obj.getCell(i, j, q)); }, k, grid_obj.nz, grid_obj.dz);
+}
+
+/*
+ * Shift advection beta^m d_m of a per-cell quantity picked by f, with the
+ * upwinded stencil along each axis and the FD closure at the line ends.
+ */
+template <typename Func>
+float advect_cells(Grid &grid_obj, int i, int j, int k, Func f) {
+	const int p[3] = { i, j, k };
+	const int n[3] = { grid_obj.nx, grid_obj.ny, grid_obj.nz };
+	const float h[3] = { grid_obj.dx, grid_obj.dy, grid_obj.dz };
+	float sum = 0.0f;
+	for (int m = 0; m < 3; m++) {
+		const float b = grid_obj.at(F_BETA(m), i, j, k);
+		auto get = [&, m](int q) {
+			int r[3] = { i, j, k };
+			r[m] = q;
+			return f(grid_obj.getCell(r[0], r[1], r[2]));
+		};
+		sum += b * FD::upwind(line_closure(get, p[m], n[m]), b, h[m]);
+	}
+	return sum;
 }
 
+/*
+ * Field overloads of the stencils above: they read one SoA component
+ * through D::offset instead of going through whole cells, so they work on
+ * the linear and the brick layout alike (for the linear one the offsets
+ * fold back into base +- constant strides). The arrays carry GHOST layers
+ * refreshed by Grid::fill_ghosts(), so every physical point gets the same
+ * straight-line FD_ORDER stencil with no boundary tests; the boundary
+ * treatment lives entirely in the ghost fill.
+ * */
+
+template <typename D = GridDims<0>>
+inline float partialX(Grid &grid_obj, int i, int j, int k, Field f) {
+	const float *u = grid_obj.field(f);
+	return FD::first([&](int s) { return u[D::offset(grid_obj, i+s, j, k)]; }, D::dx(grid_obj));
+}
+
+template <typename D = GridDims<0>>
+inline float partialY(Grid &grid_obj, int i, int j, int k, Field f) {
+	const float *u = grid_obj.field(f);
+	return FD::first([&](int s) { return u[D::offset(grid_obj, i, j+s, k)]; }, D::dy(grid_obj));
+}
+
+template <typename D = GridDims<0>>
+inline float partialZ(Grid &grid_obj, int i, int j, int k, Field f) {
+	const float *u = grid_obj.field(f);
+	return FD::first([&](int s) { return u[D::offset(grid_obj, i, j, k+s)]; }, D::dz(grid_obj));
+}
+
+/* D::offset of (i, j, k) moved by s along axis a and t along axis b */
+template <typename D>
+inline ptrdiff_t shifted_offset(const Grid &grid_obj, int i, int j, int k, int a, int s, int b = 0, int t = 0) {
+	int p[3] = { i, j, k };
+	p[a] += s;
+	p[b] += t;
+	return D::offset(grid_obj, p[0], p[1], p[2]);
+}
+
+template <typename D = GridDims<0>>
+inline float partial_m(Grid &grid_obj, int i, int j, int k, int dim, Field f) {
+    if (dim == 0) return partialX<D>(grid_obj, i, j, k, f);
+    if (dim == 1) return partialY<D>(grid_obj, i, j, k, f);
+    return partialZ<D>(grid_obj, i, j, k, f);
+}
+
+/* sum over x, y and z of the Kreiss-Oliger operator on a padded array u */
+template <typename D = GridDims<0>>
+inline float ko_dissipation(const Grid &grid_obj, const float *u, int i, int j, int k) {
+	return KO::apply([&](int s) { return u[D::offset(grid_obj, i+s, j, k)]; }, D::dx(grid_obj))
+	     + KO::apply([&](int s) { return u[D::offset(grid_obj, i, j+s, k)]; }, D::dy(grid_obj))
+	     + KO::apply([&](int s) { return u[D::offset(grid_obj, i, j, k+s)]; }, D::dz(grid_obj));
+}
+
+/*
+ * Pencil engine: the FD_ORDER first derivative along dir of a padded
+ * array u for the whole k-row (i, j, kb..ke-1) handed out by for_each_row(),
+ * written to out at the same offsets. The row and its i/j neighbour rows
+ * are unit stride, so the loop is one SIMD pass; only z neighbours crossing
+ * a brick edge need a full offset. Line ends need no closure here, the
+ * ghost layers filled by Grid::fill_ghosts() are the closure.
+ */
+template <typename D = GridDims<0>>
+inline void pencil_d1(const Grid &grid_obj, const float *u, int dir, int i, int j, int kb, int ke, float *out) {
+	/* offset(p, q, k) = row(p, q) + k for every k of this row */
+	auto row = [&](int p, int q) { return D::offset(grid_obj, p, q, kb) - kb; };
+	const ptrdiff_t c = row(i, j);
+	out += c;
+	if (dir == 2) {
+		const float h = D::dz(grid_obj);
+		auto zoff = [&](int k) -> ptrdiff_t {
+			return GRID_BRICK ? D::offset(grid_obj, i, j, k) : c + k;
+		};
+		#pragma omp simd
+		for (int k = kb; k < ke; k++)
+			out[k] = FD::first([&](int s) { return u[zoff(k + s)]; }, h);
+		return;
+	}
+	const int di = (dir == 0), dj = (dir == 1);
+	const float h = dir == 0 ? D::dx(grid_obj) : D::dy(grid_obj);
+	/* rows[s + R] is the neighbour row s points along dir */
+	const float *rows[2 * FD::R + 1];
+	for (int s = -FD::R; s <= FD::R; s++)
+		rows[s + FD::R] = u + row(i + s*di, j + s*dj);
+	#pragma omp simd
+	for (int k = kb; k < ke; k++)
+		out[k] = FD::first([&](int s) { return rows[s + FD::R][k]; }, h);
+}
+
+/*
+ * Pencil Hessian: the six packed d_a d_b of a padded array u at FD_ORDER
+ * for the k-row (i, j, kb..ke-1), out[c] addressed like out in pencil_d1().
+ * The pure second derivatives are single stencils. The mixed ones share 1D
+ * sweeps instead of running cross stencils: d_y on the x neighbour rows
+ * gives d_x d_y, d_z on the x and y neighbour rows gives d_x d_z and
+ * d_y d_z, each finished by one first derivative stencil over a small tile
+ * of those sweeps. Rows are handled in chunks of HESS_CHUNK points so the
+ * tiles stay on the stack and in L1.
+ */
+template <typename D = GridDims<0>>
+inline void pencil_hessian(const Grid &grid_obj, const float *u, int i, int j, int kb, int ke,
+                           float *const out[SYM_NCOMP]) {
+	constexpr int R = FD::R, W = 2 * R + 1, HESS_CHUNK = 64;
+	const float hx = D::dx(grid_obj), hy = D::dy(grid_obj), hz = D::dz(grid_obj);
+	auto row = [&](int p, int q) { return D::offset(grid_obj, p, q, kb) - kb; };
+	auto zoff = [&](int p, int q, ptrdiff_t r, int k) -> ptrdiff_t {
+		return GRID_BRICK ? D::offset(grid_obj, p, q, k) : r + k;
+	};
+
+	/* rows[s][t] is the row (i + s - R, j + t - R), unit stride in k */
+	const float *rows[W][W];
+	ptrdiff_t roff[W][W];
+	for (int s = 0; s < W; s++)
+		for (int t = 0; t < W; t++) {
+			roff[s][t] = row(i + s - R, j + t - R);
+			rows[s][t] = u + roff[s][t];
+		}
+	const ptrdiff_t c = roff[R][R];
+
+	/* dy_x[s], dz_x[s], dz_y[s]: d_y, d_z on row i + s - R and d_z on row j + s - R */
+	float dy_x[W][HESS_CHUNK], dz_x[W][HESS_CHUNK], dz_y[W][HESS_CHUNK];
+	for (int k0 = kb; k0 < ke; k0 += HESS_CHUNK) {
+		const int n = std::min(HESS_CHUNK, ke - k0);
+		for (int s = 0; s < W; s++) {
+			if (s == R)
+				continue;
+			const int p = i + s - R, q = j + s - R;
+			#pragma omp simd
+			for (int l = 0; l < n; l++) {
+				const int k = k0 + l;
+				dy_x[s][l] = FD::first([&](int t) { return rows[s][t + R][k]; }, hy);
+				dz_x[s][l] = FD::first([&](int t) { return u[zoff(p, j, roff[s][R], k + t)]; }, hz);
+				dz_y[s][l] = FD::first([&](int t) { return u[zoff(i, q, roff[R][s], k + t)]; }, hz);
+			}
+		}
+		#pragma omp simd
+		for (int l = 0; l < n; l++) {
+			const int k = k0 + l;
+			const ptrdiff_t o = c + k;
+			out[0][o] = FD::second([&](int s) { return rows[s + R][R][k]; }, hx);
+			out[3][o] = FD::second([&](int s) { return rows[R][s + R][k]; }, hy);
+			out[5][o] = FD::second([&](int s) { return u[zoff(i, j, c, k + s)]; }, hz);
+			out[1][o] = FD::first([&](int s) { return dy_x[s + R][l]; }, hx);
+			out[2][o] = FD::first([&](int s) { return dz_x[s + R][l]; }, hx);
+			out[4][o] = FD::first([&](int s) { return dz_y[s + R][l]; }, hy);
+		}
+	}
+}
+
+/*
+ * Pencil advection: beta^m d_m u over the k-row (i, j, kb..ke-1) with the
+ * upwinded stencil along each axis, beta read from the padded shift arrays
+ * at the same offsets, out addressed like pencil_d1(). FD::upwind selects
+ * the side per point by blend, so the loop stays a single SIMD pass.
+ */
+template <typename D = GridDims<0>>
+inline void pencil_advect(const Grid &grid_obj, const float *u, const float *const beta[3],
+                          int i, int j, int kb, int ke, float *out) {
+	constexpr int L = FD::REACH, W = 2 * L + 1;
+	const float hx = D::dx(grid_obj), hy = D::dy(grid_obj), hz = D::dz(grid_obj);
+	auto row = [&](int p, int q) { return D::offset(grid_obj, p, q, kb) - kb; };
+	const ptrdiff_t c = row(i, j);
+	auto zoff = [&](int k) -> ptrdiff_t {
+		return GRID_BRICK ? D::offset(grid_obj, i, j, k) : c + k;
+	};
+	/* rx[s + L], ry[s + L]: the rows s points along x and along y */
+	const float *rx[W], *ry[W];
+	for (int s = -L; s <= L; s++) {
+		rx[s + L] = u + row(i + s, j);
+		ry[s + L] = u + row(i, j + s);
+	}
+	const float *bx = beta[0] + c, *by = beta[1] + c, *bz = beta[2] + c;
+	out += c;
+	#pragma omp simd
+	for (int k = kb; k < ke; k++) {
+		out[k] = bx[k] * FD::upwind([&](int s) { return rx[s + L][k]; }, bx[k], hx)
+		       + by[k] * FD::upwind([&](int s) { return ry[s + L][k]; }, by[k], hy)
+		       + bz[k] * FD::upwind([&](int s) { return u[zoff(k + s)]; }, bz[k], hz);
+	}
+}
+
+/*
+ * First derivative of one of the NUM_DERIV_FIELDS cached fields: a single
+ * load from the DerivativeCache while it is valid for the current stage,
+ * the stencil above otherwise (initial data, GRID_DERIV_CACHE=0).
+ */
+template <typename D = GridDims<0>>
+inline float partial_cached(Grid &grid_obj, int i, int j, int k, int dim, Field f) {
+#if GRID_DERIV_CACHE
+	if (f < NUM_DERIV_FIELDS && grid_obj.derivativesCached())
+		return grid_obj.deriv(dim, f)[D::offset(grid_obj, i, j, k)];
+#endif
+	return partial_m<D>(grid_obj, i, j, k, dim, f);
+}
+
+/*
+ * Second derivative d_a d_b of a field at order FD_ORDER: the centred
+ * second difference when a == b, the product of two first derivative
+ * stencils otherwise. The mixed stencil reaches the edge and corner ghosts,
+ * which fill_ghosts() keeps consistent.
+ */
+template <typename D = GridDims<0>>
+inline float second_partial(Grid &grid_obj, int i, int j, int k, int a, int b, Field f) {
+    const float h[3] = { D::dx(grid_obj), D::dy(grid_obj), D::dz(grid_obj) };
+    const float *u = grid_obj.field(f);
+    if (a == b) {
+        return FD::second([&](int s) { return u[shifted_offset<D>(grid_obj, i, j, k, a, s)]; }, h[a]);
+    }
+    return FD::mixed([&](int s, int t) { return u[shifted_offset<D>(grid_obj, i, j, k, a, s, b, t)]; },
+                     safe_dx(h[a]), safe_dx(h[b]));
+}
+
+/* beta^m d_m of a field at (i, j, k), upwinded along each axis */
+template <typename D = GridDims<0>>
+inline float advect_point(Grid &grid_obj, int i, int j, int k, Field f) {
+	const float h[3] = { D::dx(grid_obj), D::dy(grid_obj), D::dz(grid_obj) };
+	const float *u = grid_obj.field(f);
+	const ptrdiff_t o = D::offset(grid_obj, i, j, k);
+	float sum = 0.0f;
+	for (int m = 0; m < 3; m++) {
+		const float b = grid_obj.field(F_BETA(m))[o];
+		sum += b * FD::upwind([&](int s) { return u[shifted_offset<D>(grid_obj, i, j, k, m, s)]; }, b, h[m]);
+	}
+	return sum;
+}
+
+/*
+ * Packed component c of the Hessian of HESS_FIELD[h]: one load from the
+ * DerivativeCache while it is valid, second_partial() otherwise.
+ */
+template <typename D = GridDims<0>>
+inline float second_cached(Grid &grid_obj, int i, int j, int k, int h, int c) {
+#if GRID_DERIV_CACHE
+	if (grid_obj.derivativesCached())
+		return grid_obj.deriv2(h, c)[D::offset(grid_obj, i, j, k)];
+#endif
+	return second_partial<D>(grid_obj, i, j, k, SYM_A[c], SYM_B[c], HESS_FIELD[h]);
+}
+
+/* advection of ADV_FIELD[a]: cached while valid, advect_point() otherwise */
+template <typename D = GridDims<0>>
+inline float advect_cached(Grid &grid_obj, int i, int j, int k, int a) {
+#if GRID_DERIV_CACHE
+	if (grid_obj.derivativesCached())
+		return grid_obj.advection(a)[D::offset(grid_obj, i, j, k)];
+#endif
+	return advect_point<D>(grid_obj, i, j, k, ADV_FIELD[a]);
+}
+
+/* first derivatives of all NUM_DERIV_FIELDS fields at (i, j, k) into pd.d1 */
+template <typename D = GridDims<0>>
+inline void load_first_derivatives(Grid &grid_obj, int i, int j, int k, PointDerivatives &pd) {
+	for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+		for (int m = 0; m < 3; m++)
+			pd.d1[m][f] = partial_cached<D>(grid_obj, i, j, k, m, Field(f));
+}
 
 template <typename Getter>
 float partial_m(Grid &grid_obj, int i, int j, int k, int dim, Getter getter) {
@@ -157,37 +616,22 @@ float partial_m(Grid &grid_obj, int i, int j, int k, int dim, Getter getter) {
     return 0.0;
 }
 
-template <typename Getter>
-float second_partial(Grid &grid_obj, int i, int j, int k, int a, int b, Getter getter) {
-    if (a == b) {
-        if (a == 0 && i >= 1 && i <= NX - 2) {
-            return (getter(grid_obj.getCell(i+1, j, k)) - 2.0 * getter(grid_obj.getCell(i, j, k)) + getter(grid_obj.getCell(i-1, j, k))) / (DX * DX);
-        } else if (a == 1 && j >= 1 && j <= NY - 2) {
-            return (getter(grid_obj.getCell(i, j+1, k)) - 2.0 * getter(grid_obj.getCell(i, j, k)) + getter(grid_obj.getCell(i, j-1, k))) / (DY * DY);
-        } else if (a == 2 && k >= 1 && k <= NZ - 2) {
-            return (getter(grid_obj.getCell(i, j, k+1)) - 2.0 * getter(grid_obj.getCell(i, j, k)) + getter(grid_obj.getCell(i, j, k-1))) / (DZ * DZ);
-        }
-    } else {
-        int ip = i, im = i, jp = j, jm = j, kp = k, km = k;
-        if (a == 0) { ip = i + 1; im = i - 1; }
-        if (a == 1) { jp = j + 1; jm = j - 1; }
-        if (a == 2) { kp = k + 1; km = k - 1; }
-
-        if (b == 0) { ip = i + 1; im = i - 1; }
-        if (b == 1) { jp = j + 1; jm = j - 1; }
-        if (b == 2) { kp = k + 1; km = k - 1; }
-
-        float dx_a = (a == 0) ? DX : (a == 1) ? DY : DZ;
-        float dx_b = (b == 0) ? DX : (b == 1) ? DY : DZ;
-
-        dx_a = safe_dx(dx_a);
-        dx_b = safe_dx(dx_b);
-
-        return (getter(grid_obj.getCell(ip, jp, kp)) - getter(grid_obj.getCell(ip, jm, km))
-              - getter(grid_obj.getCell(im, jp, kp)) + getter(grid_obj.getCell(im, jm, km)))
-              / (4.0 * dx_a * dx_b);
-    }
-
-    return 0.0;
+/*
+ * Fused derivative pass of one RK stage at one point: the cached first
+ * derivatives, the cached Hessians of alpha and chi and the shift
+ * advection of every advected quantity, K_trace included, each computed
+ * exactly once. Everything the RHS
+ * reads from neighbours goes through here.
+ */
+template <typename D = GridDims<0>>
+inline void load_point_derivatives(Grid &grid_obj, int i, int j, int k, PointDerivatives &pd) {
+	load_first_derivatives<D>(grid_obj, i, j, k, pd);
+	for (int c = 0; c < SYM_NCOMP; c++) {
+		pd.dd_alpha[c] = second_cached<D>(grid_obj, i, j, k, HESS_ALPHA, c);
+		pd.dd_chi[c] = second_cached<D>(grid_obj, i, j, k, HESS_CHI, c);
+	}
+	for (int a = 0; a < NUM_ADV_FIELDS; a++)
+		pd.adv[a] = advect_cached<D>(grid_obj, i, j, k, a);
+	pd.adv_K_trace = advect_cells(grid_obj, i, j, k,
+		[](const Grid::Cell2D &c) { return c.curv.K_trace; });
 }
-
@@ -43,9 +43,12 @@ using MatrixNDIM = std::array<std::array<float, NDIM>, NDIM>;
 #include <matrix.h>
 #include <Metric.h>
 #include <Connexion.h>
+#include <MemoryBudget.h>
+#include <MethodOfLines.h>
 #include <Grid.h>
 #include <GridTensor.h>
 #include <Derivatives.h>
+#include <SpectralDerivative.h>
 #include <Log.h>
 
 typedef struct {
@@ -111,7 +114,7 @@ int Riemann_tensor(const char *metric);
 int Geodesics_prob();
 int light_geodesics_prob(); 
 int Metric_prob();
-int grid_setup(); 
+int grid_setup(int N); 
 void generate_blackhole_image();
 void generate_blackhole_shadow();
 void evolveADM(Grid::Cell2D& cell, int i, int j, float dt, 
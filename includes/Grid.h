@@ -1,18 +1,377 @@
 #pragma once
 
 #include <Geodesics.h>
+#include <algorithm>
 
 #define DIM3 3
-constexpr float DX = 0.08;
-constexpr float DY = 0.08;
-constexpr float DZ = 0.08;
-#define NX 128
-#define NY 128
-#define NZ 128
-#define GHOST 2  
-#define NX_TOTAL (NX + 2*GHOST) 
-#define NY_TOTAL (NY + 2*GHOST)
-#define NZ_TOTAL (NZ + 2*GHOST)
+constexpr float DX_DEFAULT = 0.08;
+constexpr float DY_DEFAULT = 0.08;
+constexpr float DZ_DEFAULT = 0.08;
+#ifndef NX_DEFAULT
+# define NX_DEFAULT 128
+#endif
+#ifndef NY_DEFAULT
+# define NY_DEFAULT 128
+#endif
+#ifndef NZ_DEFAULT
+# define NZ_DEFAULT 128
+#endif
+/*
+ * Accuracy order of the centred finite-difference stencils (2, 4, 6 or 8),
+ * see FDStencil in Derivatives.h. make ORDER=6 selects it per build.
+ */
+#ifndef FD_ORDER
+# define FD_ORDER 4
+#endif
+static_assert(FD_ORDER == 2 || FD_ORDER == 4 || FD_ORDER == 6 || FD_ORDER == 8,
+              "FD_ORDER must be 2, 4, 6 or 8");
+/*
+ * 1: shift advection terms beta^m d_m use the lopsided FD_ORDER stencil
+ * picked by the sign of beta^m, which reaches one point further than the
+ * centred one. 0: centred advection, one ghost layer less per side.
+ */
+#ifndef GRID_UPWIND
+# define GRID_UPWIND 1
+#endif
+/*
+ * Width of the ghost layer padded around every axis of the grid arrays:
+ * the reach of the FD_ORDER stencils (radius FD_ORDER / 2, plus one for the
+ * lopsided advection stencil), so they can be applied unchanged at the
+ * first and last physical point. Ghosts are written only by
+ * Grid::fill_ghosts().
+ */
+#define GHOST (FD_ORDER / 2 + GRID_UPWIND)
+/*
+ * Kreiss-Oliger dissipation added to the RHS of every integrated field:
+ * order KO_ORDER (even, its stencil reaches KO_ORDER / 2 points, which
+ * must fit in the ghost layers) and strength KO_SIGMA, 0 switching it off.
+ * An order 2r operator is O(h^(2r-1)), so the default is FD_ORDER + 2,
+ * which keeps the RHS at FD_ORDER, whenever the upwind ghost layer leaves
+ * room for its stencil, and FD_ORDER otherwise. The GRID_KO_SIGMA
+ * environment variable overrides the strength.
+ */
+#ifndef KO_ORDER
+# if (FD_ORDER + 2) / 2 <= GHOST
+#  define KO_ORDER (FD_ORDER + 2)
+# else
+#  define KO_ORDER FD_ORDER
+# endif
+#endif
+#ifndef KO_SIGMA
+# define KO_SIGMA 0.1
+#endif
+static_assert(KO_ORDER % 2 == 0 && KO_ORDER >= 2 && KO_ORDER / 2 <= GHOST,
+              "KO_ORDER must be even and its stencil fit in GHOST");
+#define NX_TOTAL (NX_DEFAULT + 2*GHOST) 
+#define NY_TOTAL (NY_DEFAULT + 2*GHOST)
+#define NZ_TOTAL (NZ_DEFAULT + 2*GHOST)
+
+/*
+ * Cubic resolutions that get a dedicated instantiation of the hot kernels
+ * (RHS, Christoffel, Ricci, derivative stencils) with the extents folded in
+ * as constants. Any other size runs through the generic GridDims<0> path.
+ */
+#define GRID_FAST_SIZES(X) X(32) X(64) X(128) X(256)
+
+/*
+ * Memory layout of the padded grid arrays. 0 keeps them linear with k
+ * fastest. A power of two B stores them as B^3 bricks, brick-major, so
+ * the neighbours an FD stencil reaches in i and j sit a few
+ * bricks away instead of whole planes away. Loops that visit the grid
+ * through for_each_row() then go brick by brick.
+ */
+#ifndef GRID_BRICK
+# define GRID_BRICK 0
+#endif
+static_assert((GRID_BRICK & (GRID_BRICK - 1)) == 0, "GRID_BRICK must be 0 or a power of two");
+
+/* n physical points plus ghost layers on both ends, rounded up to whole bricks */
+constexpr int padded_extent(int n, int ghost) {
+#if GRID_BRICK
+	return (n + 2 * ghost + GRID_BRICK - 1) / GRID_BRICK * GRID_BRICK;
+#else
+	return n + 2 * ghost;
+#endif
+}
+
+/* linear offset of padded coordinates (I, J, K) for padded extents py, pz */
+constexpr size_t layout_index(int I, int J, int K, int py, int pz) {
+#if GRID_BRICK
+	constexpr unsigned B = GRID_BRICK;
+	const unsigned ui = I, uj = J, uk = K;
+	return ((static_cast<size_t>(ui / B) * (py / B) + uj / B) * (pz / B) + uk / B) * (B * B * B)
+	     + ((ui % B) * B + uj % B) * B + uk % B;
+#else
+	return (static_cast<size_t>(I) * py + J) * pz + K;
+#endif
+}
+
+#define FIELD_ALIGNMENT 64
+#define RK_MAX_REGS 4
+
+/*
+ * register slots used by the classic RK4 integrator: the step-start state,
+ * the weighted RHS accumulator and the state of the next stage
+ */
+enum RKRegister : int { RK_Y0 = 0, RK_ACC, RK_STAGE, RK4_NREGS };
+/* the single register of the 2N-storage integrator */
+enum LSRKRegister : int { LSRK_DQ = 0, LSRK_NREGS };
+/* the embedded pair adds its error accumulator to the RK4 slots */
+enum ERKRegister : int { RK_ERR = RK4_NREGS, ERK_NREGS };
+/*
+ * 1: evolve() steps with the five-stage fourth-order 2N-storage scheme of
+ * Carpenter and Kennedy, one register per evolved field (make LSRK=1).
+ * 0: classic RK4 over RK4_NREGS registers.
+ */
+#ifndef GRID_LSRK
+# define GRID_LSRK 0
+#endif
+/*
+ * 1: evolve() steps with the embedded Bogacki-Shampine 3(2) pair under a
+ * PI step-size controller (make ADAPTIVE=1): each attempt is accepted when
+ * the weighted RMS of the embedded error estimate is within RK_RTOL /
+ * RK_ATOL (GRID_RK_RTOL / GRID_RK_ATOL in the environment override them)
+ * and retried with a smaller dt otherwise. dt never exceeds the Courant
+ * limit RK_CFL_MAX. A step still rejected after RK_MAX_REJECTS attempts,
+ * or pushed below RK_DT_MIN times the Courant dt, aborts the run.
+ */
+#ifndef GRID_ADAPTIVE
+# define GRID_ADAPTIVE 0
+#endif
+#ifndef RK_RTOL
+# define RK_RTOL 1e-4
+#endif
+#ifndef RK_ATOL
+# define RK_ATOL 1e-5
+#endif
+#ifndef RK_CFL_MAX
+# define RK_CFL_MAX 1.0
+#endif
+#ifndef RK_MAX_REJECTS
+# define RK_MAX_REJECTS 20
+#endif
+#ifndef RK_DT_MIN
+# define RK_DT_MIN 1e-6
+#endif
+/*
+ * 1: evolve() runs the method-of-lines driver (make MOL=1): the evolved
+ * fields form a MolState registry and each step is one step() of the
+ * MethodOfLines.h integrator GRID_MOL_SCHEME names at run time (rk4,
+ * ssprk3, lsrk or imex), with the stage updates as separate streaming
+ * passes. 0: the fused stage sweeps above.
+ */
+#ifndef GRID_MOL
+# define GRID_MOL 0
+#endif
+static_assert(!(GRID_LSRK && GRID_ADAPTIVE), "GRID_LSRK and GRID_ADAPTIVE are exclusive");
+static_assert(!(GRID_MOL && (GRID_LSRK || GRID_ADAPTIVE)), "GRID_MOL replaces GRID_LSRK and GRID_ADAPTIVE");
+#if GRID_ADAPTIVE
+# define RK_NREGS ERK_NREGS
+# define RK_STAGES 4
+# define RK_NAME "adaptive Bogacki-Shampine 3(2)"
+#elif GRID_LSRK
+# define RK_NREGS LSRK_NREGS
+# define RK_STAGES 5
+# define RK_NAME "2N-storage RK4(5)"
+#elif GRID_MOL
+/* the scheme is picked at run time, the memory plan budgets the largest */
+# define RK_NREGS RK_MAX_REGS
+# define RK_STAGES 4
+# define RK_NAME "method of lines"
+#else
+# define RK_NREGS RK4_NREGS
+# define RK_STAGES 4
+# define RK_NAME "classic RK4"
+#endif
+
+/*
+ * PI step-size controller of the embedded pair: err is the weighted RMS
+ * error of the last attempt, 1 at tolerance.
+ */
+struct StepControl {
+	float rtol = RK_RTOL;
+	float atol = RK_ATOL;
+	float err_prev = 1.0f;
+	int accepted = 0;
+	int rejected = 0;
+
+	/* true when err <= 1; dt becomes the size of the next step or retry */
+	bool update(float err, float &dt, float dt_max);
+};
+
+/* RK_RTOL / RK_ATOL, or GRID_RK_RTOL / GRID_RK_ATOL from the environment */
+StepControl step_control();
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#ifndef GRID_HUGEPAGES
+# define GRID_HUGEPAGES 1
+#endif
+/*
+ * 1: first derivatives of the cached fields, the Hessians of alpha and chi
+ * and the shift advection terms are computed once per RK stage into
+ * Grid::DerivativeCache (DerivativeCache::NARRAYS extra arrays).
+ * 0: no extra memory, every consumer recomputes its stencils.
+ */
+#ifndef GRID_DERIV_CACHE
+# define GRID_DERIV_CACHE 1
+#endif
+/*
+ * 1: the cached first derivatives of the BSSN RHS come from the sixth
+ * order compact scheme (CompactFD.cpp, make COMPACT=1) instead of the
+ * explicit FD_ORDER stencil. Needs the derivative cache.
+ */
+#ifndef GRID_COMPACT
+# define GRID_COMPACT 0
+#endif
+static_assert(!GRID_COMPACT || GRID_DERIV_CACHE, "GRID_COMPACT needs GRID_DERIV_CACHE");
+/*
+ * 1: bind each thread's slab of every grid array to its NUMA node with
+ * mbind() (needs libnuma, make NUMA=1). 0: rely on first touch alone.
+ */
+#ifndef GRID_NUMA
+# define GRID_NUMA 0
+#endif
+/*
+ * 1: builds the FFTW spectral derivative engine for periodic data
+ * (SpectralDerivative.h, needs libfftw3f and libfftw3f_threads, make
+ * SPECTRAL=1), checked at startup by report_spectral_accuracy(). The
+ * evolution keeps its finite differences either way. 0: FFTW is not
+ * linked.
+ */
+#ifndef GRID_SPECTRAL
+# define GRID_SPECTRAL 0
+#endif
+
+/*
+ * Packed symmetric 3x3 tensor: only the 6 independent components are stored,
+ * in the order xx, xy, xz, yy, yz, zz. (a, b) and (b, a) map to the same slot.
+ */
+constexpr int SYM_NCOMP = 6;
+constexpr int SYM_IDX[3][3] = { {0, 1, 2}, {1, 3, 4}, {2, 4, 5} };
+constexpr int SYM_A[SYM_NCOMP] = {0, 0, 0, 1, 1, 2};
+constexpr int SYM_B[SYM_NCOMP] = {0, 1, 2, 1, 2, 2};
+/* weight of each packed slot in a full double sum over (a, b) */
+constexpr float SYM_W[SYM_NCOMP] = {1.0f, 2.0f, 2.0f, 1.0f, 2.0f, 1.0f};
+
+constexpr int sym_idx(int a, int b) { return SYM_IDX[a][b]; }
+
+struct Sym3 {
+	float v[SYM_NCOMP];
+
+	inline float& operator()(int a, int b) { return v[SYM_IDX[a][b]]; }
+	inline float operator()(int a, int b) const { return v[SYM_IDX[a][b]]; }
+	inline float& operator[](int n) { return v[n]; }
+	inline float operator[](int n) const { return v[n]; }
+};
+
+/* A^{ab} B_{ab} for two symmetric tensors */
+inline float sym_contract(const Sym3 &A, const Sym3 &B) {
+	float s = 0.0f;
+	for (int n = 0; n < SYM_NCOMP; n++)
+		s += SYM_W[n] * A.v[n] * B.v[n];
+	return s;
+}
+
+/* (l m r)_{ab} = l_{ac} m^{cd} r_{db}, symmetric when l == r */
+inline float sym_sandwich(const Sym3 &l, const Sym3 &m, const Sym3 &r, int a, int b) {
+	float s = 0.0f;
+	for (int c = 0; c < 3; c++)
+		for (int d = 0; d < 3; d++)
+			s += l(a, c) * m(c, d) * r(d, b);
+	return s;
+}
+
+/* T^{ab} = g^{ac} g^{bd} T_{cd} */
+inline void sym_raise(const Sym3 &ginv, const Sym3 &T, Sym3 &out) {
+	for (int n = 0; n < SYM_NCOMP; n++)
+		out.v[n] = sym_sandwich(ginv, T, ginv, SYM_A[n], SYM_B[n]);
+}
+
+/*
+ * Largest characteristic speed along each axis at a point,
+ * v_m = |alpha| sqrt(gamma^mm) + |beta^m| with gamma^mm = chi tilde
+ * gamma^mm, the diagonal of the inverse of the packed conformal metric gt.
+ */
+inline void characteristic_speed(float alpha, const float beta[3], float chi, const float gt[SYM_NCOMP],
+                                 float v[3]) {
+	const float cxx = gt[3] * gt[5] - gt[4] * gt[4];
+	const float cyy = gt[0] * gt[5] - gt[2] * gt[2];
+	const float czz = gt[0] * gt[3] - gt[1] * gt[1];
+	const float det = gt[0] * cxx - gt[1] * (gt[1] * gt[5] - gt[4] * gt[2]) + gt[2] * (gt[1] * gt[4] - gt[3] * gt[2]);
+	const float s = std::fabs(chi) / std::max(std::fabs(det), 1e-12f);
+	const float a = std::fabs(alpha);
+	v[0] = a * std::sqrt(std::fabs(cxx) * s) + std::fabs(beta[0]);
+	v[1] = a * std::sqrt(std::fabs(cyy) * s) + std::fabs(beta[1]);
+	v[2] = a * std::sqrt(std::fabs(czz) * s) + std::fabs(beta[2]);
+}
+
+/*
+ * Evolved BSSN variables live outside Cell2D, one contiguous array per
+ * component (field-major / SoA). A stencil along any axis then only streams
+ * the component it differentiates instead of whole 1.6 KB cells. Symmetric
+ * tensors keep their 6 independent components only.
+ */
+enum Field : int {
+	F_ALPHA = 0,
+	F_BETA0, F_BETA1, F_BETA2,
+	F_CHI,
+	F_GTXX, F_GTXY, F_GTXZ, F_GTYY, F_GTYZ, F_GTZZ,
+	F_ATXX, F_ATXY, F_ATXZ, F_ATYY, F_ATYZ, F_ATZZ,
+	F_KXX,  F_KXY,  F_KXZ,  F_KYY,  F_KYZ,  F_KZZ,
+	NUM_FIELDS
+};
+
+/*
+ * Fields whose first derivatives are cached per stage: alpha, beta, chi
+ * and tilde_gamma, i.e. the leading block of Field up to Atilde. Atilde
+ * is only ever advected, which the advection cache below covers.
+ */
+constexpr int NUM_DERIV_FIELDS = F_ATXX;
+
+/*
+ * Scalars whose whole Hessian is cached per stage too: the lapse and the
+ * conformal factor, the only fields the BSSN RHS takes second derivatives of.
+ */
+constexpr int NUM_HESS_FIELDS = 2;
+constexpr Field HESS_FIELD[NUM_HESS_FIELDS] = { F_ALPHA, F_CHI };
+constexpr int HESS_ALPHA = 0, HESS_CHI = 1;
+
+/*
+ * Fields whose shift advection beta^m d_m u is cached per stage: alpha, chi,
+ * tilde_gamma and Atilde, in that order (see adv_slot()).
+ */
+constexpr int NUM_ADV_FIELDS = 2 + 2 * SYM_NCOMP;
+constexpr Field ADV_FIELD[NUM_ADV_FIELDS] = {
+	F_ALPHA, F_CHI,
+	F_GTXX, F_GTXY, F_GTXZ, F_GTYY, F_GTYZ, F_GTZZ,
+	F_ATXX, F_ATXY, F_ATXZ, F_ATYY, F_ATYZ, F_ATZZ
+};
+constexpr int adv_slot(Field f) {
+	return f == F_ALPHA ? 0 : f == F_CHI ? 1 : f < F_ATXX ? 2 + (f - F_GTXX) : 2 + SYM_NCOMP + (f - F_ATXX);
+}
+
+constexpr Field F_BETA(int m)      { return Field(F_BETA0 + m); }
+constexpr Field F_GT(int a, int b) { return Field(F_GTXX + sym_idx(a, b)); }
+constexpr Field F_AT(int a, int b) { return Field(F_ATXX + sym_idx(a, b)); }
+constexpr Field F_K(int a, int b)  { return Field(F_KXX + sym_idx(a, b)); }
+
+/*
+ * Every derivative the BSSN RHS needs at one point, gathered once per stage
+ * by load_point_derivatives() (Derivatives.h) and handed to the Christoffel,
+ * Ricci and chi kernels instead of each of them going back to the grid.
+ * d1[m][f] is partial_m of cached field f, adv the shift advection terms.
+ */
+struct PointDerivatives {
+	float d1[3][NUM_DERIV_FIELDS];
+	Sym3 dd_alpha;
+	Sym3 dd_chi;
+	float adv[NUM_ADV_FIELDS];
+	float adv_K_trace;
+
+	inline float d(int m, Field f) const { return d1[m][f]; }
+	/* beta^m d_m of an ADV_FIELD, upwinded when GRID_UPWIND */
+	inline float advect(Field f) const { return adv[adv_slot(f)]; }
+};
 
 using Matrix4x4 = std::array<std::array<float, NDIM>, NDIM>;
 using Matrix3x3 = std::array<std::array<float, DIM3>, DIM3>;
@@ -26,12 +385,10 @@ using Riemann3D = std::array<std::array<std::array<std::array<float, DIM3>, DIM3
 struct alignas(32) Geometry {
     Matrix3x3 gamma;
     Matrix3x3 gamma_inv;
-    Matrix3x3 Ricci;
+    Sym3 Ricci;
     Matrix3x3 gamma0;
-    float tilde_gamma[3][3];
-    float tilde_gamma0[3][3];
-    float tildgamma_inv[3][3];
-    float dt_tilde_gamma[3][3];
+    Sym3 tildgamma_inv;
+    Sym3 dt_tilde_gamma;
     float dt_tildeGamma[3];
 };
 
@@ -42,31 +399,19 @@ struct alignas(32) Connection {
 };
 
 struct alignas(32) ExtrinsicCurvature {
-    Matrix3x3 K;
-    Matrix3x3 K0;
     float K_trace;
     float dt_K_trace;
     float H;
-    float dKt[3][3];
+    Sym3 dKt;
 };
 
 struct alignas(32) AtildeVars {
-    float Atilde[3][3];
-    float Atilde0[3][3];
-    float dt_Atilde[3][3];
-    float AtildeStage[4][3][3];
+    Sym3 dt_Atilde;
 };
 
 struct alignas(32) Gauge {
-    float alpha;
-    float alpha0;
-    float alphaStage[4];
     Vector3 dalpha_dx;
 
-    float beta[3];
-    float beta0[3];
-    float betaStage[4][3];
-    float Bstage[4][3];
 	float dt_beta[3];
 	float dt_alpha;
 };
@@ -81,13 +426,32 @@ struct Matter {
 };
 
 
+template <int N> struct GridDims;
+
 class Grid {
     public:
+		Grid(int nx_ = NX_DEFAULT, int ny_ = NY_DEFAULT, int nz_ = NZ_DEFAULT,
+			 float dx_ = DX_DEFAULT, float dy_ = DY_DEFAULT, float dz_ = DZ_DEFAULT)
+			: nx(nx_), ny(ny_), nz(nz_), dx(dx_), dy(dy_), dz(dz_) {}
+		~Grid();
+		Grid(const Grid &) = delete;
+		Grid &operator=(const Grid &) = delete;
 
-		std::vector<float> dgammaX[3][3];
-		std::vector<float> dgammaY[3][3];
-		std::vector<float> dgammaZ[3][3];
 		float time = 0.0;
+		/* Kreiss-Oliger strength applied by storeStage(), see KO_SIGMA */
+		float ko_sigma = KO_SIGMA;
+		/*
+		 * Per-axis maximum characteristic speed of the current state,
+		 * reduced by the last stage sweep of every step for the next
+		 * computeCFL_dt(); computeMaxSpeed() fills it when not valid.
+		 */
+		float max_speed[3] = {};
+		bool max_speed_valid = false;
+
+		/* runtime extents and spacing, fixed once the grid is allocated */
+		int nx, ny, nz;
+		float dx, dy, dz;
+
 		struct alignas(32) Cell2D {
 			Geometry geom;
 			Connection conn;
@@ -97,25 +461,88 @@ class Grid {
 			Matter matter;
 			float t;
 			float ADMmass;
-			float chi;
 			float dt_chi;
-			float gammaStage[4][3][3];
-			float KStage[4][3][3];
-			float dgt[3][3];
+			Sym3 dgt;
 		};
 
+		/*
+		 * Single owning allocation behind the grid: the Cell2D array and every
+		 * evolved field share one FIELD_ALIGNMENT-aligned block (optionally
+		 * backed by transparent huge pages), and a point is addressed by a
+		 * linear offset instead of three nested std::vector hops.
+		 */
 		struct alignas(32) GridStorage {
-			Cell2D* cells;
+			Cell2D* cells = nullptr;
+			float* fields[NUM_FIELDS] = {};
 
-			float* alpha;
-			float* chi;
-			float* Atilde[3][3];
+			void* block = nullptr;
+			size_t bytes = 0;
+			bool hugePages = false;
 
-			int nx, ny, nz;
+			int nx = 0, ny = 0, nz = 0;
+			int ghost = 0;
+			int px = 0, py = 0, pz = 0;	/* padded extents, see padded_extent() */
 
-			inline int idx(int i, int j, int k) const {
-				return i * ny * nz + j * nz + k;
+			/* (i, j, k) are physical indices, ghosts sit at -ghost..-1 and n..n+ghost-1 */
+			inline size_t idx(int i, int j, int k) const {
+				return layout_index(i + ghost, j + ghost, k + ghost, py, pz);
+			}
+			inline size_t size() const {
+				return static_cast<size_t>(px) * py * pz;
 			}
+
+			void allocate(int nx_, int ny_, int nz_, int ghost_, bool useHugePages);
+			void release();
+			static size_t bytes_for(int nx_, int ny_, int nz_, int ghost_, bool useHugePages);
+		};
+
+		/*
+		 * Integrator scratch kept out of Cell2D: nregs SoA copies of the
+		 * NUM_FIELDS evolved components, sized by the time scheme (classic
+		 * RK4 needs the step-start state, a weighted RHS accumulator and the
+		 * next stage state, see RKRegister). RK4 rotates the integrated
+		 * field pointers between these and GridStorage::fields instead of
+		 * copying, so either block may hold the current state.
+		 */
+		struct StageRegisters {
+			float* reg[RK_MAX_REGS][NUM_FIELDS] = {};
+			int nregs = 0;
+			size_t npts = 0;
+
+			void* block = nullptr;
+			size_t bytes = 0;
+			bool hugePages = false;
+
+			void allocate(size_t npts_, int nregs_, bool useHugePages);
+			void release();
+			static size_t bytes_for(size_t npts_, int nregs_, bool useHugePages);
+		};
+
+		/*
+		 * d[m][f] holds partial_m of field f (f < NUM_DERIV_FIELDS),
+		 * dd[h][c] packed component c of the Hessian of HESS_FIELD[h] and
+		 * adv[a] the shift advection of ADV_FIELD[a], on the same padded
+		 * layout as GridStorage. Filled once per RK stage after the ghosts
+		 * are refreshed, read through partial_cached(), second_cached() and
+		 * advect_cached(); valid is cleared whenever the evolved state moves on.
+		 */
+		struct DerivativeCache {
+			static constexpr int NARRAYS = 3 * NUM_DERIV_FIELDS + NUM_HESS_FIELDS * SYM_NCOMP
+			                             + NUM_ADV_FIELDS;
+
+			float* d[3][NUM_DERIV_FIELDS] = {};
+			float* dd[NUM_HESS_FIELDS][SYM_NCOMP] = {};
+			float* adv[NUM_ADV_FIELDS] = {};
+			size_t npts = 0;
+			bool valid = false;
+
+			void* block = nullptr;
+			size_t bytes = 0;
+			bool hugePages = false;
+
+			void allocate(size_t npts_, bool useHugePages);
+			void release();
+			static size_t bytes_for(size_t npts_, bool useHugePages);
 		};
 
 		void appendConstraintL2ToCSV(const std::string& filename, float time) const;
@@ -125,16 +552,33 @@ class Grid {
 		void initialize_grid();
 		void evolve(Grid &grid_obj, float dtinitital, int nSteps);
 		float KUpAt(Grid &grid, int ip, int jp, int kp, int j_up, int i_low);
-		void copyInitialState(Cell2D &cell);
-		void updateIntermediateState(Cell2D &cell, float dtCoeff, int stageIndex);
-		void storeStage(Cell2D &cell, int stage, float d_alpha_dt, float d_beta_dt[3]) ;
-		void combineStages(Cell2D &cell, float dt);
+		template <typename D = GridDims<0>>
+		float storeStage(int stage, float dt, int i, int j, int k, float d_alpha_dt, float d_beta_dt[3],
+		                 const StepControl &ctl);
+		void holdStagePoint(int stage, int i, int j, int k);
+		void updateStageState(int stage, float dt);
+		void rejectStep();
+		float stepError(double sum) const;
+		static size_t stage_traffic_bytes(size_t npts);
 		void initialize_grid(int Nr, int Ntheta, float r_min, float r_max, float theta_min, float theta_max);
-		float computeMaxSpeed();
+		void computeMaxSpeed(float speed[3]);
 		float computeCFL_dt(float CFL);
+		template <typename D = GridDims<0>>
+		void rowMaxSpeed(int i, int j, int kb, int ke, float speed[3]) const;
 		void compute_constraints(Grid &grid_obj, int i, int j, int k, float &hamiltonian, float momentum[3]);
+		template <typename D = GridDims<0>>
 		void compute_time_derivatives(Grid &grid_obj, int i, int j, int k);
+		template <typename D>
+		void evolve_steps(Grid &grid_obj, float dtinitital, int nSteps);
+		template <typename D>
+		void evolve_mol(Grid &grid_obj, float dtinitital, int nSteps);
+		void mol_registry(MolState &y, MolState *reg, int nregs);
+		template <typename D = GridDims<0>>
+		void mol_rhs(const MolState &k, bool last, bool split_damping);
+		void mol_damping_rhs(const MolState &k);
+		void mol_damping_solve(float gdt);
 		void allocateGlobalGrid();
+		static size_t memory_plan(int nx_, int ny_, int nz_, bool verbose);
 		void initializeData_Minkowski();
 		void initializeKerrData(Grid &grid_obj);
 		void initializeBinaryKerrData(Grid &grid_obj);
@@ -143,17 +587,133 @@ class Grid {
 		float partialZ_KUp(Grid &grid, int i, int j, int k, int j_up, int i_low);
 		float computeTraceK(Grid &grid, int i, int j, int k);
 		void compute_gauge_derivatives(Grid &grid_obj, int i, int j, int k, float &d_alpha_dt, float d_beta_dt[3]);
-		void injectTTWave(Cell2D &cell, float x, float y, float z, float t);
+		float shift_damping(int i, int j, int k) const;
+		void injectTTWave(int i, int j, int k, float x, float y, float z, float t);
 		void solve_lichnerowicz(int max_iter, float tol, float dx, float dy, float dz);
 		Cell2D& getCell(int i, int j, int k) {
-			return globalGrid[i][j][k];
+			return storage.cells[storage.idx(i, j, k)];
+		}
+		const Cell2D& getCell(int i, int j, int k) const {
+			return storage.cells[storage.idx(i, j, k)];
 		}
+
+		void copyPoint(int id, int jd, int kd, int is, int js, int ks);
+		void fill_ghosts();
+		template <typename D = GridDims<0>>
+		void fill_derivative_cache();
+		template <typename D = GridDims<0>>
+		void fill_compact_derivatives();
+		template <typename D = GridDims<0>>
+		void report_derivative_throughput();
+		template <typename D = GridDims<0>>
+		void report_dissipation_overhead();
+#if GRID_SPECTRAL
+		void report_spectral_accuracy();
+		void report_chebyshev_accuracy();
+#endif
+
+		inline size_t idx(int i, int j, int k) const { return storage.idx(i, j, k); }
+		inline float* field(Field f) { return storage.fields[f]; }
+		inline const float* field(Field f) const { return storage.fields[f]; }
+		inline bool derivativesCached() const { return dcache.valid; }
+		inline const float* deriv(int dim, Field f) const { return dcache.d[dim][f]; }
+		inline const float* deriv2(int h, int c) const { return dcache.dd[h][c]; }
+		inline const float* advection(int a) const { return dcache.adv[a]; }
+		inline float& at(Field f, int i, int j, int k) { return storage.fields[f][idx(i, j, k)]; }
+		inline float at(Field f, int i, int j, int k) const { return storage.fields[f][idx(i, j, k)]; }
 		void export_Atildedt_slide(Grid &grid_obj, float time);
 	private:
-		std::vector<std::vector<std::vector<Grid::Cell2D>>> globalGrid;
+		friend struct DerivativeBench;
+		GridStorage storage;
+		StageRegisters rk;
+		DerivativeCache dcache;
 
 };
 
+/*
+ * Extent / spacing policy for the templated kernels. GridDims<N> is a cube of
+ * N points per axis known at compile time, so strides and loop bounds become
+ * immediates; GridDims<0> forwards to the values stored on the Grid.
+ * offset() addresses the GHOST-padded arrays in whatever layout GRID_BRICK
+ * selects; stencils reach neighbours through it rather than raw strides.
+ */
+template <int N>
+struct GridDims {
+	static constexpr bool fixed = true;
+	static constexpr int P = padded_extent(N, GHOST);
+	static constexpr int nx(const Grid &) { return N; }
+	static constexpr int ny(const Grid &) { return N; }
+	static constexpr int nz(const Grid &) { return N; }
+	static constexpr ptrdiff_t offset(const Grid &, int i, int j, int k) {
+		return layout_index(i + GHOST, j + GHOST, k + GHOST, P, P);
+	}
+	static float dx(const Grid &g) { return g.dx; }
+	static float dy(const Grid &g) { return g.dy; }
+	static float dz(const Grid &g) { return g.dz; }
+};
+
+template <>
+struct GridDims<0> {
+	static constexpr bool fixed = false;
+	static int nx(const Grid &g) { return g.nx; }
+	static int ny(const Grid &g) { return g.ny; }
+	static int nz(const Grid &g) { return g.nz; }
+	static ptrdiff_t offset(const Grid &g, int i, int j, int k) {
+		return g.idx(i, j, k);
+	}
+	static float dx(const Grid &g) { return g.dx; }
+	static float dy(const Grid &g) { return g.dy; }
+	static float dz(const Grid &g) { return g.dz; }
+};
+
+/*
+ * Calls fn(GridDims<N>{}) with the specialised policy when the grid is a cube
+ * of one of the GRID_FAST_SIZES, GridDims<0>{} otherwise. Returns N (0 for
+ * the generic path) so callers can report which kernels ran.
+ */
+template <typename Fn>
+inline int dispatch_dims(const Grid &g, Fn &&fn) {
+#define GRID_DISPATCH_CASE(N) \
+	if (g.nx == N && g.ny == N && g.nz == N) { fn(GridDims<N>{}); return N; }
+	GRID_FAST_SIZES(GRID_DISPATCH_CASE)
+#undef GRID_DISPATCH_CASE
+	fn(GridDims<0>{});
+	return 0;
+}
+
+/*
+ * Hands [i0, i1) x [j0, j1) x [k0, k1) out as k-rows fn(i, j, kb, ke) from
+ * an orphaned static omp for. With GRID_BRICK the work items are whole
+ * bricks and each row stays inside one brick, so points kb..ke-1 of a row
+ * are contiguous in memory in both layouts.
+ */
+template <typename Fn>
+inline void for_each_row(int i0, int i1, int j0, int j1, int k0, int k1, Fn &&fn) {
+#if GRID_BRICK
+	constexpr int B = GRID_BRICK;
+	const int bi0 = (i0 + GHOST) / B, bi1 = (i1 - 1 + GHOST) / B + 1;
+	const int bj0 = (j0 + GHOST) / B, bj1 = (j1 - 1 + GHOST) / B + 1;
+	const int bk0 = (k0 + GHOST) / B, bk1 = (k1 - 1 + GHOST) / B + 1;
+	#pragma omp for collapse(3) schedule(static)
+	for (int bi = bi0; bi < bi1; bi++) {
+		for (int bj = bj0; bj < bj1; bj++) {
+			for (int bk = bk0; bk < bk1; bk++) {
+				const int ib = std::max(i0, bi * B - GHOST), ie = std::min(i1, (bi + 1) * B - GHOST);
+				const int jb = std::max(j0, bj * B - GHOST), je = std::min(j1, (bj + 1) * B - GHOST);
+				const int kb = std::max(k0, bk * B - GHOST), ke = std::min(k1, (bk + 1) * B - GHOST);
+				for (int i = ib; i < ie; i++)
+					for (int j = jb; j < je; j++)
+						fn(i, j, kb, ke);
+			}
+		}
+	}
+#else
+	#pragma omp for collapse(2) schedule(static)
+	for (int i = i0; i < i1; i++)
+		for (int j = j0; j < j1; j++)
+			fn(i, j, k0, k1);
+#endif
+}
 
 float partialXX_alpha(Grid &grid_obj, int i, int j, int k);
 float partialYY_alpha(Grid &grid_obj, int i, int j, int k);
@@ -161,6 +721,7 @@ float partialZZ_alpha(Grid &grid_obj, int i, int j, int k);
 float second_partial_alpha(Grid &grid_obj, int i, int j, int k, int a, int b);
 bool invert_3x3(const float m[3][3], float inv[3][3]);
 void apply_boundary_conditions(Grid &grid_obj);
+void report_page_placement(const char *what, const void *block, size_t bytes);
 void export_K_3D(Grid &grid_obj);
 void export_alpha_slice(Grid &grid_obj, int j);
 void export_gauge_slice(Grid &grid_obj, int j);
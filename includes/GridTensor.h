@@ -7,17 +7,20 @@ class GridTensor {
 		GridTensor() = default;
 		~GridTensor() = default;    
 		friend class Grid;
+		friend struct DerivativeBench;
 		void export_christoffel_slice(Grid &grid_obj, int j);
 		void compute_extrinsic_curvature(Grid &grid_obj, int i, int j, int k, \
 											 float dx, float dy, float dz);
 		void compute_Atilde(Grid &grid_obj, int i, int j, int k);
 	protected:
+		template <typename D = GridDims<0>>
 		void compute_christoffel_3D(Grid &grid_obj, int i, int j, int k, float christof[3][3][3]);
+		void compute_christoffel_3D(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float christof[3][3][3]);
 		void compute_dt_tildeGamma(Grid &grid_obj, int i, int j, int k, float dt_tildeGamma[3]); 
 		void compute_tildeGamma(Grid &grid_obj, int i, int j, int k, float tildeGamma[3]);
 		void compute_partial_christoffel(Grid &grid_obj, int i, int j, int k, int dim, float partialGamma[3][3][3][3], float d);
-		void compute_ricci_conformal_factor(Grid &grid_obj, int i, int j, int k, float RicciChi[3][3]);
-		void compute_ricci_BSSN(Grid &grid_obj, int i, int j, int k, float Ricci[3][3]);
+		void compute_ricci_conformal_factor(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float RicciChi[3][3]);
+		void compute_ricci_BSSN(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float Ricci[3][3]);
 		void compute_ricci_3D_conformal(Grid &grid_obj, int i, int j, int k, float Ricci[3][3]);
 		void compute_ricci_3d(
 				Grid& grid_obj,  
@@ -41,7 +44,8 @@ class BSSNevolve {
 		BSSNevolve() = default;
 		~BSSNevolve() = default;
 		friend class Grid;
-		void compute_dt_chi(Grid &grid_obj, int i, int j, int k, float &dt_chi);
+		friend struct DerivativeBench;
+		void compute_dt_chi(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float &dt_chi);
 		void compute_dt_tilde_gamma(Grid &grid_obj, int i, int j, int k, float dt_tg[3][3]);
 
 	protected:
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Bookkeeping for the large allocations of an ADM run. Every owner of a
+ * grid-sized block reports it here by subsystem, so the run can print what
+ * it holds, what it peaked at and check a plan against a memory budget
+ * before committing to a resolution.
+ */
+enum MemSubsystem : int {
+	MEM_GRID = 0,		/* cells + evolved fields (GridStorage) */
+	MEM_RK,				/* integrator registers (StageRegisters) */
+	MEM_DERIV_CACHE,	/* per-stage derivatives and Hessians (DerivativeCache) */
+	MEM_CONSTRAINTS,	/* hamiltonianGrid */
+	MEM_ELLIPTIC,		/* Lichnerowicz psi, initial data only */
+	MEM_SPECTRAL,		/* FFTW buffers of the SpectralDerivative engines */
+	MEM_NSUB
+};
+
+/*
+ * Budget in MB, 0 meaning unlimited. The GRID_MEM_BUDGET_MB environment
+ * variable overrides the compiled-in value so batch scripts can size a run
+ * to the node without rebuilding.
+ */
+#ifndef GRID_MEM_BUDGET_MB
+# define GRID_MEM_BUDGET_MB 0
+#endif
+
+/* smallest cube grid_setup() will downscale to before giving up */
+#define GRID_MIN_N 16
+
+class MemoryBudget {
+	public:
+		static void track(MemSubsystem sub, const char *what, size_t bytes);
+		static void untrack(MemSubsystem sub, size_t bytes);
+		static size_t current();
+		static size_t peak();
+		static size_t budget();
+		static const char *name(MemSubsystem sub);
+		static void report();
+
+	private:
+		static size_t held[MEM_NSUB];
+		static size_t peakBytes;
+};
+
+/* bytes of a std::vector<std::vector<std::vector<float>>> of nx*ny*nz */
+size_t nested_vector_bytes(int nx, int ny, int nz);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+
+/* most variables one registry holds */
+#define MOL_MAX_VARS 32
+/* most scratch registries an integrator asks for */
+#define MOL_MAX_REGS 4
+
+/* integrator of the method-of-lines driver, GRID_MOL_SCHEME in the environment overrides it */
+#ifndef MOL_SCHEME
+# define MOL_SCHEME "rk4"
+#endif
+
+/*
+ * Method of lines over flat arrays. The evolved system is a registry of
+ * nvar arrays of npts floats each; the integrators only ever combine whole
+ * registries point by point, so they know nothing of the grid, its layout
+ * or which tensor a variable belongs to, and the physics only supplies
+ * the right-hand side through MolRHS. Scratch registries have the layout
+ * of the state they serve.
+ */
+struct MolState {
+	float *var[MOL_MAX_VARS] = {};
+	const char *name[MOL_MAX_VARS] = {};
+	int nvar = 0;
+	size_t npts = 0;
+
+	inline void add(const char *nm, float *data) {
+		name[nvar] = nm;
+		var[nvar++] = data;
+	}
+};
+
+/*
+ * out = sum_t c[t] x[t], one streaming pass per variable; out may be one
+ * of the x[t]. Orphaned worksharing with a static schedule, so every
+ * thread keeps to the slice it first-touched: call it from all threads of
+ * a parallel region. Ends with a barrier.
+ */
+template <int T>
+inline void mol_lincomb(const MolState &out, const float (&c)[T], const MolState *const (&x)[T]) {
+	for (int v = 0; v < out.nvar; v++) {
+		float *o = out.var[v];
+		const float *src[T];
+		for (int t = 0; t < T; t++)
+			src[t] = x[t]->var[v];
+		#pragma omp for simd schedule(static) nowait
+		for (size_t n = 0; n < out.npts; n++) {
+			float s = 0.0f;
+			for (int t = 0; t < T; t++)
+				s += c[t] * src[t][n];
+			o[n] = s;
+		}
+	}
+	#pragma omp barrier
+}
+
+/* every entry of out set to value, same contract as mol_lincomb() */
+void mol_fill(const MolState &out, float value);
+
+/*
+ * Right-hand side of dy/dt = f(y) + g(y). f is the non-stiff part every
+ * scheme evaluates; g, the stiff part, is only seen by the IMEX scheme and
+ * is zero unless overridden. All calls come from every thread of the
+ * parallel region the integrator runs in, and y is always the registry
+ * the integrator was given, updated in place.
+ */
+class MolRHS {
+	public:
+		virtual ~MolRHS() = default;
+
+		/* k = f(y); last is set on the final evaluation of a step */
+		virtual void rhs(const MolState &y, const MolState &k, bool last) = 0;
+		/* k = g(y) */
+		virtual void stiff_rhs(const MolState &y, const MolState &k);
+		/* y becomes the Y solving Y = y + gdt g(Y) */
+		virtual void stiff_solve(float gdt, const MolState &y);
+};
+
+/*
+ * A time integrator over registries: step() advances y by dt in place
+ * with nregs() scratch registries, evaluating the RHS stages() times.
+ * Stateless, so one instance serves every run.
+ */
+class MolIntegrator {
+	public:
+		virtual ~MolIntegrator() = default;
+
+		virtual const char *name() const = 0;
+		virtual int nregs() const = 0;
+		virtual int stages() const = 0;
+		/* registries streamed by the stage updates of one step, reads plus writes */
+		virtual int traffic() const = 0;
+		/* true when step() takes MolRHS's stiff part implicitly, f alone otherwise */
+		virtual bool imex() const { return false; }
+		/* from every thread of a parallel region */
+		virtual void step(MolRHS &f, const MolState &y, const MolState *reg, float dt) const = 0;
+};
+
+/* "rk4", "ssprk3", "lsrk" or "imex"; NULL for any other name */
+const MolIntegrator *mol_integrator(const char *name);
+/* MOL_SCHEME, or GRID_MOL_SCHEME from the environment; NULL if unknown */
+const MolIntegrator *mol_scheme();
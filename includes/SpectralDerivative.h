@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Lines of at least this many Chebyshev nodes are differentiated through
+ * the DCT when FFTW is built in; shorter ones, and every line without
+ * FFTW, through the dense collocation matrix.
+ */
+#ifndef GRID_CHEB_DCT_MIN
+# define GRID_CHEB_DCT_MIN 32
+#endif
+
+#if GRID_SPECTRAL
+#include <fftw3.h>
+
+/* wisdom file, GRID_FFTW_WISDOM in the environment overrides it */
+#ifndef GRID_FFTW_WISDOM
+# define GRID_FFTW_WISDOM "fftwf.wisdom"
+#endif
+
+/*
+ * Fourier first derivatives of periodic data on an nx x ny x nz box of
+ * periods lx, ly, lz. A batch of up to nbatch real fields, each packed
+ * without ghosts and k fastest like the grid, goes through one batched
+ * real-to-complex transform; every requested axis is then one multiply by
+ * i k_m and one batched complex-to-real transform back. Plans are built
+ * once per shape with FFTW_MEASURE on FFTW's own thread pool, and the
+ * wisdom is kept in GRID_FFTW_WISDOM so later runs plan in no time.
+ *
+ * forward() and backward() run their own parallel loops: call them from
+ * serial code, never from inside the evolve() parallel region.
+ */
+class SpectralDerivative {
+	public:
+		/* the engine for this shape and batch, planned on first use */
+		static SpectralDerivative &get(int nx, int ny, int nz, float lx, float ly, float lz, int nbatch);
+
+		~SpectralDerivative();
+		SpectralDerivative(const SpectralDerivative &) = delete;
+		SpectralDerivative &operator=(const SpectralDerivative &) = delete;
+
+		/* slot b of the batch, npts packed values, read by forward() */
+		inline float *in(int b) { return real + b * npts; }
+		/* slot b after backward(), overwritten by the next transform */
+		inline const float *out(int b) const { return real + b * npts; }
+
+		/* spectrum of the whole batch; the in() slots are consumed */
+		void forward();
+		/* d_m of every slot of the last forward() into the out() slots */
+		void backward(int m);
+
+		/* du[f][m] = d_m u[f] for f < nf, in batches; du[f][m] may be null */
+		void gradient(const float *const u[], float *const du[][3], int nf);
+
+		int n[3];
+		int nbatch;
+		size_t npts;	/* nx * ny * nz */
+		size_t nspec;	/* nx * ny * (nz / 2 + 1) */
+		size_t bytes;
+
+	private:
+		SpectralDerivative(int nx, int ny, int nz, float lx, float ly, float lz, int nbatch);
+
+		float l[3];		/* periods, part of the shape get() matches on */
+		std::vector<float> kw[3];	/* i k_m / npts per index of axis m, 0 at Nyquist */
+		float *real;
+		fftwf_complex *spec;
+		fftwf_complex *work;
+		fftwf_plan fwd;
+		fftwf_plan bwd;
+};
+
+/*
+ * Chebyshev collocation d/dx of a field sampled on chebyshev_nodes() along
+ * axis dim of an nx x ny x nz box, in O(n log n) per line: a DCT-I
+ * (REDFT00) of every line at once gives the Chebyshev coefficients, the
+ * derivative recurrence runs on them in place, and the same DCT-I brings
+ * the derivative back. One guru plan covers all lines of the field and is
+ * its own inverse up to the 1 / (n - 1) folded into the recurrence.
+ * Like SpectralDerivative: planned once per shape, called from serial code.
+ */
+class ChebyshevDCT {
+	public:
+		static ChebyshevDCT &get(int nx, int ny, int nz, int dim);
+
+		~ChebyshevDCT();
+		ChebyshevDCT(const ChebyshevDCT &) = delete;
+		ChebyshevDCT &operator=(const ChebyshevDCT &) = delete;
+
+		/* du = d u / dx along dim on [a, b], packed fields, du may be u */
+		void derivative(const float *u, float *du, float a, float b);
+
+		int n[3];
+		int dim;
+		size_t npts;
+		size_t bytes;
+
+	private:
+		ChebyshevDCT(int nx, int ny, int nz, int dim);
+
+		float *buf;
+		fftwf_plan dct;
+};
+
+#endif
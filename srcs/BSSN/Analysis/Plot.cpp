@@ -17,20 +17,20 @@ void export_gamma_slice(Grid &grid_obj, int j, float time) {
          << "gamma_20,gamma_21,gamma_22\n";
 
     float L = 9.0;
-    float dx = (2.0 * L) / (NX - 1);
-    float dz = (2.0 * L) / (NZ - 1);
+    float dx = (2.0 * L) / (grid_obj.nx - 1);
+    float dz = (2.0 * L) / (grid_obj.nz - 1);
 
-    for (int i = 0; i < NX; ++i) {
-        for (int k = 0; k < NZ; ++k) {
+    for (int i = 0; i < grid_obj.nx; ++i) {
+        for (int k = 0; k < grid_obj.nz; ++k) {
             float x = -L + i * dx;
             float z = -L + k * dz;
 
             const Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
 
             file << x << "," << z << ","
-                 << cell.geom.dt_tilde_gamma[0][0] << "," << cell.geom.dt_tilde_gamma[0][1] << "," << cell.geom.dt_tilde_gamma[0][2] << ","
-                 << cell.geom.dt_tilde_gamma[1][0] << "," << cell.geom.dt_tilde_gamma[1][1] << "," << cell.geom.dt_tilde_gamma[1][2] << ","
-                 << cell.geom.dt_tilde_gamma[2][0] << "," << cell.geom.dt_tilde_gamma[2][1] << "," << cell.geom.dt_tilde_gamma[2][2] << "\n";
+                 << cell.geom.dt_tilde_gamma(0, 0) << "," << cell.geom.dt_tilde_gamma(0, 1) << "," << cell.geom.dt_tilde_gamma(0, 2) << ","
+                 << cell.geom.dt_tilde_gamma(1, 0) << "," << cell.geom.dt_tilde_gamma(1, 1) << "," << cell.geom.dt_tilde_gamma(1, 2) << ","
+                 << cell.geom.dt_tilde_gamma(2, 0) << "," << cell.geom.dt_tilde_gamma(2, 1) << "," << cell.geom.dt_tilde_gamma(2, 2) << "\n";
         }
     }
 
@@ -43,10 +43,10 @@ void Grid::appendConstraintL2ToCSV(const std::string& filename, float time) cons
     float sum_Mx = 0.0, sum_My = 0.0, sum_Mz = 0.0;
     int N = 0;
 
-    for (int i = 1; i < NX - 1; ++i) {
-        for (int j = 1; j < NY - 1; ++j) {
-            for (int k = 1; k < NZ - 1; ++k) {
-                const Cell2D &cell = globalGrid[i][j][k];
+    for (int i = 1; i < nx - 1; ++i) {
+        for (int j = 1; j < ny - 1; ++j) {
+            for (int k = 1; k < nz - 1; ++k) {
+                const Cell2D &cell = getCell(i, j, k);
                 sum_H  += cell.matter.hamiltonian * cell.matter.hamiltonian;
                 sum_Mx += cell.matter.momentum[0] * cell.matter.momentum[0];
                 sum_My += cell.matter.momentum[1] * cell.matter.momentum[1];
@@ -86,13 +86,13 @@ void Grid::export_Atildedt_slide(Grid &grid_obj, float time) {
 	sprintf(filename, "Output/Atildedt_slice_t%.3f.dat", time);
 	file.open(filename);
 	float L = 19.0;
-	int z_mid = NY / 2;
+	int z_mid = grid_obj.ny / 2;
 
-	for (int i = 0; i < NX; ++i) {
-		for (int j = 0; j < NY; ++j) {
-			float x = -L + i * DX;
-			float y = -L + j * DY;
-			float Atildedt = globalGrid[i][j][z_mid].atilde.dt_Atilde[0][0];
+	for (int i = 0; i < grid_obj.nx; ++i) {
+		for (int j = 0; j < grid_obj.ny; ++j) {
+			float x = -L + i * grid_obj.dx;
+			float y = -L + j * grid_obj.dy;
+			float Atildedt = getCell(i, j, z_mid).atilde.dt_Atilde(0, 0);
 			file << x << " " << y << " " << Atildedt << "\n";
 		}
 		file << "\n";
@@ -105,17 +105,17 @@ void export_K_slice(Grid &grid_obj, int j) {
 
     file << "x,z,K00,K01,K02,K10,K11,K12,K20,K21,K22\n";
 
-    for (int i = 0; i < NX; i++) {
-        for (int k = 0; k < NZ; k++) {
-            float x = -12.0 + i * (9.0 / (NX - 1));
-            float z = -12.0 + k * (9.0 / (NZ - 1));
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int k = 0; k < grid_obj.nz; k++) {
+            float x = -12.0 + i * (9.0 / (grid_obj.nx - 1));
+            float z = -12.0 + k * (9.0 / (grid_obj.nz - 1));
 
             Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
 
             file << x << "," << z << ","
-                 << cell.atilde.dt_Atilde[0][0] << "," << cell.atilde.dt_Atilde[0][1] << "," << cell.atilde.dt_Atilde[0][2] << ","
-                 << cell.atilde.dt_Atilde[1][0] << "," << cell.atilde.dt_Atilde[1][1] << "," << cell.atilde.dt_Atilde[1][2] << ","
-                 << cell.atilde.dt_Atilde[2][0] << "," << cell.atilde.dt_Atilde[2][1] << "," << cell.atilde.dt_Atilde[2][2] << "\n";
+                 << cell.atilde.dt_Atilde(0, 0) << "," << cell.atilde.dt_Atilde(0, 1) << "," << cell.atilde.dt_Atilde(0, 2) << ","
+                 << cell.atilde.dt_Atilde(1, 0) << "," << cell.atilde.dt_Atilde(1, 1) << "," << cell.atilde.dt_Atilde(1, 2) << ","
+                 << cell.atilde.dt_Atilde(2, 0) << "," << cell.atilde.dt_Atilde(2, 1) << "," << cell.atilde.dt_Atilde(2, 2) << "\n";
         }
     }
     file.close();
@@ -137,7 +137,7 @@ void export_K_3D(Grid &grid_obj) {
     file << "ASCII\n";
     file << "DATASET STRUCTURED_POINTS\n";
 
-    file << "DIMENSIONS " << NX << " " << NY << " " << NZ << "\n";
+    file << "DIMENSIONS " << grid_obj.nx << " " << grid_obj.ny << " " << grid_obj.nz << "\n";
 
     float x0 = -9.0;
     float y0 = -9.0;
@@ -145,41 +145,40 @@ void export_K_3D(Grid &grid_obj) {
     float a = 0.9999;  
     file << "ORIGIN " << x0 << " " << y0 << " " << z0 << "\n";
 
-    float dx = 18.0 / (NX - 1);
-    float dy = 18.0 / (NY - 1);
-    float dz = 18.0 / (NZ - 1);
+    float dx = 18.0 / (grid_obj.nx - 1);
+    float dy = 18.0 / (grid_obj.ny - 1);
+    float dz = 18.0 / (grid_obj.nz - 1);
     file << "SPACING " << dx << " " << dy << " " << dz << "\n";
 
-    file << "POINT_DATA " << (NX * NY * NZ) << "\n";
+    file << "POINT_DATA " << (grid_obj.nx * grid_obj.ny * grid_obj.nz) << "\n";
     file << "TENSORS K float\n";
 
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
-                Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
-                file << cell.atilde.Atilde[0][0] << " " << cell.atilde.Atilde[0][1] << " " << cell.atilde.Atilde[0][2] << "\n";
-                file << cell.atilde.Atilde[1][0] << " " << cell.atilde.Atilde[1][1] << " " << cell.atilde.Atilde[1][2] << "\n";
-                file << cell.atilde.Atilde[2][0] << " " << cell.atilde.Atilde[2][1] << " " << cell.atilde.Atilde[2][2] << "\n\n";
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
+                for (int a = 0; a < 3; a++)
+                    file << grid_obj.at(F_AT(a, 0), i, j, k) << " " << grid_obj.at(F_AT(a, 1), i, j, k) << " " << grid_obj.at(F_AT(a, 2), i, j, k) << "\n";
+                file << "\n";
             }
         }
     }
     file << "TENSORS dKt float\n";
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
                 Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
-                file << cell.atilde.dt_Atilde[0][0] << " " << cell.atilde.dt_Atilde[0][1] << " " << cell.atilde.dt_Atilde[0][2] << "\n";
-                file << cell.atilde.dt_Atilde[1][0] << " " << cell.atilde.dt_Atilde[1][1] << " " << cell.atilde.dt_Atilde[1][2] << "\n";
-                file << cell.atilde.dt_Atilde[2][0] << " " << cell.atilde.dt_Atilde[2][1] << " " << cell.atilde.dt_Atilde[2][2] << "\n\n";
+                file << cell.atilde.dt_Atilde(0, 0) << " " << cell.atilde.dt_Atilde(0, 1) << " " << cell.atilde.dt_Atilde(0, 2) << "\n";
+                file << cell.atilde.dt_Atilde(1, 0) << " " << cell.atilde.dt_Atilde(1, 1) << " " << cell.atilde.dt_Atilde(1, 2) << "\n";
+                file << cell.atilde.dt_Atilde(2, 0) << " " << cell.atilde.dt_Atilde(2, 1) << " " << cell.atilde.dt_Atilde(2, 2) << "\n\n";
             }
         }
     }    float r_H = M + sqrt(M * M - a * a); 
 
     file << "SCALARS Horizon float 1\n";
     file << "LOOKUP_TABLE default\n";
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
                 float x = x0 + i * dx;
                 float y = y0 + j * dy;
                 float z = z0 + k * dz;
@@ -191,9 +190,9 @@ void export_K_3D(Grid &grid_obj) {
 
     file << "SCALARS Ergosphere_plus float 1\n";
     file << "LOOKUP_TABLE default\n";
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
                 float x = x0 + i * dx;
                 float y = y0 + j * dy;
                 float z = z0 + k * dz;
@@ -206,9 +205,9 @@ void export_K_3D(Grid &grid_obj) {
 
     file << "SCALARS Ergosphere_minus float 1\n";
     file << "LOOKUP_TABLE default\n";
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
                 float x = x0 + i * dx;
                 float y = y0 + j * dy;
                 float z = z0 + k * dz;
@@ -221,9 +220,9 @@ void export_K_3D(Grid &grid_obj) {
 	
 	file << "SCALARS fluid float 1\n";
 	file << "LOOKUP_TABLE default\n";
-	for (int i = 0; i < NX; i++) {
-		for (int j = 0; j < NY; j++) {
-			for (int k = 0; k < NZ; k++) {
+	for (int i = 0; i < grid_obj.nx; i++) {
+		for (int j = 0; j < grid_obj.ny; j++) {
+			for (int k = 0; k < grid_obj.nz; k++) {
 				Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
 				file << (cell.matter.rho > 1e-10 ? 1.0 : 0.0) << "\n";
 			}
@@ -232,9 +231,9 @@ void export_K_3D(Grid &grid_obj) {
 	
 	file << "SCALARS fluid_velocity float 1\n";
 	file << "LOOKUP_TABLE default\n";
-	for (int i = 0; i < NX; i++) {
-		for (int j = 0; j < NY; j++) {
-			for (int k = 0; k < NZ; k++) {
+	for (int i = 0; i < grid_obj.nx; i++) {
+		for (int j = 0; j < grid_obj.ny; j++) {
+			for (int k = 0; k < grid_obj.nz; k++) {
 				Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
 				file << sqrt(cell.matter.vx * cell.matter.vx + cell.matter.vy * \
 						cell.matter.vy + cell.matter.vz * cell.matter.vz) << "\n";
@@ -244,20 +243,18 @@ void export_K_3D(Grid &grid_obj) {
 
 	file << "SCALARS alpha float 1\n";
 	file << "LOOKUP_TABLE default\n";
-	for (int i = 0; i < NX; i++) {
-		for (int j = 0; j < NY; j++) {
-			for (int k = 0; k < NZ; k++) {
-				auto &cell = grid_obj.getCell(i, j, k);
-				file << cell.gauge.alpha << "\n";
+	for (int i = 0; i < grid_obj.nx; i++) {
+		for (int j = 0; j < grid_obj.ny; j++) {
+			for (int k = 0; k < grid_obj.nz; k++) {
+				file << grid_obj.at(F_ALPHA, i, j, k) << "\n";
 			}
 		}
 	}
 	file << "VECTORS shift float\n";
-for (int i = 0; i < NX; i++) {
-    for (int j = 0; j < NY; j++) {
-        for (int k = 0; k < NZ; k++) {
-            auto &cell = grid_obj.getCell(i, j, k);
-            file << cell.gauge.beta[0] << " " << cell.gauge.beta[1] << " " << cell.gauge.beta[2] << "\n";
+for (int i = 0; i < grid_obj.nx; i++) {
+    for (int j = 0; j < grid_obj.ny; j++) {
+        for (int k = 0; k < grid_obj.nz; k++) {
+            file << grid_obj.at(F_BETA0, i, j, k) << " " << grid_obj.at(F_BETA1, i, j, k) << " " << grid_obj.at(F_BETA2, i, j, k) << "\n";
         }
     }
 }
@@ -271,13 +268,12 @@ void export_alpha_slice(Grid &grid_obj, int j) {
     std::ofstream file("Output/alpha_slice.csv");
 
     file << "x,z,alpha\n";
-    for(int i = 0; i < NX; i++) {
-        for(int k = 0; k < NZ; k++) {
-            float x = -9.0 + i * (18.0 / (NX - 1));
-            float z = -9.0 + k * (18.0 / (NZ - 1));
+    for(int i = 0; i < grid_obj.nx; i++) {
+        for(int k = 0; k < grid_obj.nz; k++) {
+            float x = -9.0 + i * (18.0 / (grid_obj.nx - 1));
+            float z = -9.0 + k * (18.0 / (grid_obj.nz - 1));
 
-            Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
-            file << x << "," << z << "," << cell.gauge.alpha << "\n";
+            file << x << "," << z << "," << grid_obj.at(F_ALPHA, i, j, k) << "\n";
         }
     }
     file.close();
@@ -290,17 +286,17 @@ void export_gauge_slice(Grid &grid_obj, int j) {
     std::ofstream file("Output/gauge_slice.csv");
     file << "x,z,alpha,beta0,beta1,beta2,d_alpha_dt,d_beta0_dt,d_beta1_dt,d_beta2_dt\n";
 
-    for (int i = 0; i < NX; i++) {
-        for (int k = 0; k < NZ; k++) {
-            float x = -9.0 + i * (18.0 / (NX - 1));
-            float z = -9.0 + k * (18.0 / (NZ - 1));
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int k = 0; k < grid_obj.nz; k++) {
+            float x = -9.0 + i * (18.0 / (grid_obj.nx - 1));
+            float z = -9.0 + k * (18.0 / (grid_obj.nz - 1));
 
             Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
             float d_alpha_dt, d_beta_dt[3];
             grid_obj.compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
 
             file << x << "," << z << "," 
-                 << cell.gauge.alpha << "," << cell.gauge.beta[0] << "," << cell.gauge.beta[1] << "," << cell.gauge.beta[2] << ","
+                 << grid_obj.at(F_ALPHA, i, j, k) << "," << grid_obj.at(F_BETA0, i, j, k) << "," << grid_obj.at(F_BETA1, i, j, k) << "," << grid_obj.at(F_BETA2, i, j, k) << ","
                  << cell.gauge.dt_alpha << "," << cell.gauge.dt_beta[0] << "," << cell.gauge.dt_beta[1] << "," << cell.gauge.dt_beta[2] << "\n";
         }
     }
@@ -318,9 +314,9 @@ void GridTensor::export_christoffel_slice(Grid &grid_obj, int j) {
     float x_min = -L, x_max = L;
     float y_min = -L, y_max = L;
     float z_min = -L, z_max = L;
-    float dx = (x_max - x_min) / (NX - 1);
-    float dy = (y_max - y_min) / (NY - 1);
-    float dz = (z_max - z_min) / (NZ - 1);
+    float dx = (x_max - x_min) / (grid_obj.nx - 1);
+    float dy = (y_max - y_min) / (grid_obj.ny - 1);
+    float dz = (z_max - z_min) / (grid_obj.nz - 1);
     file << "x,z";
     for (int i = 0; i < 3; i++) {
         for (int k = 0; k < 3; k++) {
@@ -331,8 +327,8 @@ void GridTensor::export_christoffel_slice(Grid &grid_obj, int j) {
     }
     file << "\n";
     
-    for (int i_idx = 1; i_idx < NX-1; i_idx++) {
-        for (int k_idx = 1; k_idx < NZ-1; k_idx++) {
+    for (int i_idx = 1; i_idx < grid_obj.nx-1; i_idx++) {
+        for (int k_idx = 1; k_idx < grid_obj.nz-1; k_idx++) {
             float x = x_min + i_idx * dx;
             float z = z_min + k_idx * dz;            
             float christof[3][3][3];
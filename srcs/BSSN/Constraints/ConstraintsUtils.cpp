@@ -2,11 +2,11 @@
 
 float Grid::KUpAt(Grid &grid, int ip, int jp, int kp, int j_up, int i_low)
 {
-    if(ip<0 || ip>=NX || jp<0 || jp>=NY || kp<0 || kp>=NZ) {
+    if(ip<0 || ip>=grid.nx || jp<0 || jp>=grid.ny || kp<0 || kp>=grid.nz) {
         return 0.0;
     }
 
-    Cell2D &cell = grid.globalGrid[ip][jp][kp];
+    Cell2D &cell = grid.getCell(ip, jp, kp);
     float gtmp[3][3];
     for(int a=0; a<3; a++){
         for(int b=0; b<3; b++){
@@ -16,7 +16,7 @@ float Grid::KUpAt(Grid &grid, int ip, int jp, int kp, int j_up, int i_low)
 
     float val = 0.0;
     for(int c=0; c<3; c++){
-        val += cell.geom.gamma_inv[j_up][c] * cell.curv.K[c][i_low];
+        val += cell.geom.gamma_inv[j_up][c] * grid.at(F_K(c, i_low), ip, jp, kp);
     }
     return val;
 }
@@ -25,21 +25,21 @@ float Grid::partialX_KUp(Grid &grid, int i, int j, int k, int j_up, int i_low)
 {
     float valP = KUpAt(grid, i+1, j, k, j_up, i_low);
     float valM = KUpAt(grid, i-1, j, k, j_up, i_low);
-    return (valP - valM) / (2.0 * DX);
+    return (valP - valM) / (2.0 * grid.dx);
 }
 
 float Grid::partialY_KUp(Grid &grid, int i, int j, int k, int j_up, int i_low)
 {
     float valP = KUpAt(grid, i, j+1, k, j_up, i_low);
     float valM = KUpAt(grid, i, j-1, k, j_up, i_low);
-    return (valP - valM) / (2.0 * DY);
+    return (valP - valM) / (2.0 * grid.dy);
 }
 
 float Grid::partialZ_KUp(Grid &grid, int i, int j, int k, int j_up, int i_low)
 {
     float valP = KUpAt(grid, i, j, k+1, j_up, i_low);
     float valM = KUpAt(grid, i, j, k-1, j_up, i_low);
-    return (valP - valM) / (2.0 * DZ);
+    return (valP - valM) / (2.0 * grid.dz);
 }
 
 float divKUp_i(Grid &grid, int i, int j, int k, int i_comp)
@@ -65,7 +65,7 @@ float GridTensor::christoffelTerm(Grid &grid, int i, int j, int k, int i_comp)
             for(int bb=0; bb<3; bb++){
                 float sum=0.0;
                 for(int cc=0; cc<3; cc++){
-					sum += grid.getCell(i,j,k).geom.gamma_inv[aa][cc] * grid.getCell(i,j,k).curv.K[cc][bb];
+					sum += grid.getCell(i,j,k).geom.gamma_inv[aa][cc] * grid.at(F_K(cc, bb), i, j, k);
                 }
                 KupLocal[aa][bb] = sum;
             }
@@ -84,7 +84,7 @@ float GridTensor::christoffelTerm(Grid &grid, int i, int j, int k, int i_comp)
 
 float Grid::computeTraceK(Grid &grid, int i, int j, int k)
 {
-    Cell2D &cell = grid.globalGrid[i][j][k];
+    Cell2D &cell = grid.getCell(i, j, k);
     float gTmp[3][3];
     for(int a=0; a<3; a++){
         for(int b=0; b<3; b++){
@@ -94,7 +94,7 @@ float Grid::computeTraceK(Grid &grid, int i, int j, int k)
     float trace = 0.0;
     for(int a=0; a<3; a++){
         for(int b=0; b<3; b++){
-            trace += cell.geom.gamma_inv[a][b]*cell.curv.K[a][b];
+            trace += cell.geom.gamma_inv[a][b]*grid.at(F_K(a, b), i, j, k);
         }
     }
     return trace;
@@ -104,21 +104,21 @@ float partialX_Ktrace(Grid &grid, int i, int j, int k)
 {
     float Kp = grid.computeTraceK(grid, i+1,j,k);
     float Km = grid.computeTraceK(grid, i-1,j,k);
-    return (Kp - Km)/(2.0*DX);
+    return (Kp - Km)/(2.0*grid.dx);
 }
 
 float partialY_Ktrace(Grid &grid, int i, int j, int k)
 {
 	float Kp = grid.computeTraceK(grid, i,j+1,k);
 	float Km = grid.computeTraceK(grid, i,j-1,k);
-	return (Kp - Km)/(2.0*DY);
+	return (Kp - Km)/(2.0*grid.dy);
 }
 
 float partialZ_Ktrace(Grid &grid, int i, int j, int k)
 {
 	float Kp = grid.computeTraceK(grid, i,j,k+1);
 	float Km = grid.computeTraceK(grid, i,j,k-1);
-	return (Kp - Km)/(2.0*DZ);
+	return (Kp - Km)/(2.0*grid.dz);
 }
 
 float partial_i_Ktrace(Grid &grid, int i, int j, int k, int i_comp)
@@ -139,7 +139,7 @@ float GridTensor::compute_momentum_i(Grid &grid, int i, int j, int k, int i_comp
 
 float Grid::compute_ricci_scalar(Grid &grid, int i, int j, int k)
 {
-	Cell2D &cell = grid.globalGrid[i][j][k];
+	Cell2D &cell = grid.getCell(i, j, k);
 	Log log_obj;
 	float gTmp[3][3];
 	for(int a=0; a<3; a++){
@@ -150,7 +150,7 @@ float Grid::compute_ricci_scalar(Grid &grid, int i, int j, int k)
 	float R = 0.0;
 	for(int a=0; a<3; a++){
 		for(int b=0; b<3; b++){
-			R += cell.geom.gamma_inv[a][b]*cell.geom.Ricci[a][b];
+			R += cell.geom.gamma_inv[a][b]*cell.geom.Ricci(a, b);
 		}
 	}
 	return R;
@@ -2,27 +2,34 @@
 
 std::vector<std::vector<std::vector<float>>> hamiltonianGrid;
 void Grid::initialize_grid() {
-    globalGrid.resize(NX, std::vector<std::vector<Cell2D>>(NY, std::vector<Cell2D>(NZ)));
-    hamiltonianGrid.resize(NX, std::vector<std::vector<float>>(NY, std::vector<float>(NZ, 0.0)));
+    if (!storage.cells)
+        allocateGlobalGrid();
+    if (hamiltonianGrid.empty())
+        MemoryBudget::track(MEM_CONSTRAINTS, "hamiltonianGrid", nested_vector_bytes(nx, ny, nz));
+    hamiltonianGrid.resize(nx, std::vector<std::vector<float>>(ny, std::vector<float>(nz, 0.0)));
 }
 
 
 void Grid::compute_constraints(Grid &grid_obj, int i, int j, int k, float &hamiltonian, float momentum[3]) {
-    Cell2D &cell = globalGrid[i][j][k];
+    Cell2D &cell = getCell(i, j, k);
     float R = 0.0;
 	GridTensor grid_tensor_obj;
 	R = compute_ricci_scalar(grid_obj, i, j, k);
     float Ktrace = 0.0;
     float KK = 0.0;
+    float Kij[3][3];
+    for (int a = 0; a < 3; a++)
+        for (int b = 0; b < 3; b++)
+            Kij[a][b] = at(F_K(a, b), i, j, k);
 #pragma omp simd collapse(4)
 	for (int i = 0; i < 3; i++) {
 		for (int j = 0; j < 3; j++) {
 			for (int k = 0; k < 3; k++) {
 				for (int l = 0; l < 3; l++) {
-					KK += cell.curv.K[i][j] * 
+					KK += Kij[i][j] * 
 						cell.geom.gamma_inv[i][k] * 
 						cell.geom.gamma_inv[j][l] * 
-						cell.curv.K[k][l];
+						Kij[k][l];
 				}
 			}
 		}
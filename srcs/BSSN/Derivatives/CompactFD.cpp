@@ -0,0 +1,147 @@
+#include <Geodesics.h>
+
+/*
+ * Sixth-order compact (Pade) first derivative, Lele's tridiagonal scheme
+ *
+ *   1/3 f'_(i-1) + f'_i + 1/3 f'_(i+1)
+ *       = 14/9 (f_(i+1) - f_(i-1)) / (2h) + 1/9 (f_(i+2) - f_(i-2)) / (4h)
+ *
+ * on the physical points of every grid line, closed by the fourth-order
+ * Pade row 1/4 f'_(i-1) + f'_i + 1/4 f'_(i+1) = 3/2 (f_(i+1) - f_(i-1)) / (2h)
+ * next to each end and the fourth-order one-sided row
+ * f'_0 + 3 f'_1 = (-17/6 f_0 + 3/2 f_1 + 3/2 f_2 - 1/6 f_3) / h (mirrored)
+ * on it.
+ * Ghosts are not read: the closure rows are the boundary treatment.
+ */
+#define COMPACT_LANES 8
+
+/*
+ * Thomas factors of the line matrix, the same for every line of n points:
+ * a the sub-diagonal, cp the eliminated super-diagonal, inv the inverse
+ * pivots.
+ */
+struct CompactFactors {
+    std::vector<float> a, cp, inv;
+
+    explicit CompactFactors(int n) : a(n), cp(n), inv(n) {
+        std::vector<float> c(n);
+        for (int i = 0; i < n; i++) {
+            const bool edge = i == 1 || i == n - 2;
+            a[i] = edge ? 0.25f : 1.0f / 3.0f;
+            c[i] = edge ? 0.25f : 1.0f / 3.0f;
+        }
+        a[0] = 0.0f;
+        c[0] = 3.0f;
+        a[n - 1] = 3.0f;
+        c[n - 1] = 0.0f;
+        inv[0] = 1.0f;
+        cp[0] = c[0];
+        for (int i = 1; i < n; i++) {
+            inv[i] = 1.0f / (1.0f - a[i] * cp[i - 1]);
+            cp[i] = c[i] * inv[i];
+        }
+    }
+};
+
+/*
+ * Derivative of COMPACT_LANES interleaved lines in place: f[i][l] is point
+ * i of lane l on entry, f'[i][l] on exit, rhs scratch of the same shape.
+ * Every row is one AVX register of 8 lanes, so the sequential Thomas
+ * sweeps run on 8 lines at once.
+ */
+static void compact_solve(float (*f)[COMPACT_LANES], float (*rhs)[COMPACT_LANES], int n, float h,
+                          const CompactFactors &fac) {
+    const float ih = 1.0f / h;
+    const float c1 = 14.0f / 9.0f / 2.0f * ih, c2 = 1.0f / 9.0f / 4.0f * ih, c4 = 1.5f / 2.0f * ih;
+
+    #pragma omp simd
+    for (int l = 0; l < COMPACT_LANES; l++) {
+        rhs[0][l] = (-17.0f / 6.0f * f[0][l] + 1.5f * (f[1][l] + f[2][l]) - f[3][l] / 6.0f) * ih;
+        rhs[1][l] = c4 * (f[2][l] - f[0][l]);
+        rhs[n - 2][l] = c4 * (f[n - 1][l] - f[n - 3][l]);
+        rhs[n - 1][l] = (17.0f / 6.0f * f[n - 1][l] - 1.5f * (f[n - 2][l] + f[n - 3][l]) + f[n - 4][l] / 6.0f) * ih;
+    }
+    for (int i = 2; i < n - 2; i++) {
+        #pragma omp simd
+        for (int l = 0; l < COMPACT_LANES; l++)
+            rhs[i][l] = c1 * (f[i + 1][l] - f[i - 1][l]) + c2 * (f[i + 2][l] - f[i - 2][l]);
+    }
+
+    for (int i = 1; i < n; i++) {
+        const float a = fac.a[i], inv = fac.inv[i];
+        #pragma omp simd
+        for (int l = 0; l < COMPACT_LANES; l++)
+            rhs[i][l] = (rhs[i][l] - a * rhs[i - 1][l]) * inv;
+    }
+    #pragma omp simd
+    for (int l = 0; l < COMPACT_LANES; l++)
+        f[n - 1][l] = rhs[n - 1][l];
+    for (int i = n - 2; i >= 0; i--) {
+        const float cp = fac.cp[i];
+        #pragma omp simd
+        for (int l = 0; l < COMPACT_LANES; l++)
+            f[i][l] = rhs[i][l] - cp * f[i + 1][l];
+    }
+}
+
+/*
+ * Compact first derivatives of the NUM_DERIV_FIELDS cached fields along x,
+ * y and z into the DerivativeCache. Lines along x and y are bundled by 8
+ * consecutive k (contiguous in the linear layout), lines along z by 8
+ * consecutive j; each bundle is gathered into a [n][8] tile, solved by
+ * compact_solve() and scattered back. One orphaned worksharing loop over
+ * every (field, axis, bundle), so all threads stay busy across fields.
+ */
+template <typename D>
+void Grid::fill_compact_derivatives() {
+    const int n[3] = { D::nx(*this), D::ny(*this), D::nz(*this) };
+    const float h[3] = { D::dx(*this), D::dy(*this), D::dz(*this) };
+    const CompactFactors fac[3] = { CompactFactors(n[0]), CompactFactors(n[1]), CompactFactors(n[2]) };
+    const int nmax = std::max(n[0], std::max(n[1], n[2]));
+
+    /* per axis: outer lines P, lane axis, bundles per outer line */
+    int lane_axis[3], outer[3], bundles[3], items[4] = { 0 };
+    for (int dir = 0; dir < 3; dir++) {
+        lane_axis[dir] = dir == 2 ? 1 : 2;
+        const int other = 3 - dir - lane_axis[dir];
+        outer[dir] = n[other];
+        bundles[dir] = (n[lane_axis[dir]] + COMPACT_LANES - 1) / COMPACT_LANES;
+        items[dir + 1] = items[dir] + outer[dir] * bundles[dir];
+    }
+
+    std::vector<float> tile(2 * static_cast<size_t>(nmax) * COMPACT_LANES);
+    auto *f = reinterpret_cast<float (*)[COMPACT_LANES]>(tile.data());
+    auto *rhs = f + nmax;
+
+    #pragma omp for schedule(static)
+    for (int w = 0; w < NUM_DERIV_FIELDS * items[3]; w++) {
+        const int fld = w / items[3], r = w % items[3];
+        const int dir = r < items[1] ? 0 : r < items[2] ? 1 : 2;
+        const int p = (r - items[dir]) / bundles[dir];
+        const int q0 = (r - items[dir]) % bundles[dir] * COMPACT_LANES;
+        const int la = lane_axis[dir], oa = 3 - dir - la;
+        const int nl = std::min(COMPACT_LANES, n[la] - q0);
+
+        auto off = [&](int s, int l) {
+            int c[3];
+            c[dir] = s;
+            c[la] = q0 + std::min(l, nl - 1);
+            c[oa] = p;
+            return D::offset(*this, c[0], c[1], c[2]);
+        };
+        const float *u = storage.fields[fld];
+        float *out = dcache.d[dir][fld];
+        for (int s = 0; s < n[dir]; s++)
+            for (int l = 0; l < COMPACT_LANES; l++)
+                f[s][l] = u[off(s, l)];
+        compact_solve(f, rhs, n[dir], h[dir], fac[dir]);
+        for (int s = 0; s < n[dir]; s++)
+            for (int l = 0; l < nl; l++)
+                out[off(s, l)] = f[s][l];
+    }
+}
+
+#define INSTANTIATE_COMPACT(N) \
+	template void Grid::fill_compact_derivatives<GridDims<N>>();
+GRID_FAST_SIZES(INSTANTIATE_COMPACT)
+INSTANTIATE_COMPACT(0)
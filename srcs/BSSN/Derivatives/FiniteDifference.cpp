@@ -1,263 +1,196 @@
 #include <Geodesics.h>
 #include "Spectral.h"
 /*
- * Theses functions are used to compute the partial derivative of the metric tensor
- * and the Christoffel symbols, gauge.beta and gauge.alpha gauges conditions
- * All of these use a 2nd, fourth or sixth order finite difference scheme
+ * Finite-difference derivatives of the BSSN fields. Everything here
+ * forwards to the stencils of Derivatives.h, all templated on FD_ORDER:
+ * FD::first() and second_partial() for the SoA fields, line_d1() for
+ * quantities that only live in Cell2D.
  *
- * The functions are used in the computation of the ADM/BSSN equations
+ * The SoA fields carry GHOST layers that Grid::fill_ghosts() refreshes
+ * once per RK stage, so every physical point, boundary ones included,
+ * gets the same centred FD_ORDER stencil with no index clamps or boundary
+ * tests. Cells have no ghost layers; line_d1() closes their lines with
+ * the extrapolated FD closure instead.
  *
- * derivatives are computed using the following formulas:
- * \partial_x f = (f_{i+1} - f_{i-1}) / (2 * dx)
- * \partial_y f = (f_{j+1} - f_{j-1}) / (2 * dy)
- * \partial_z f = (f_{k+1} - f_{k-1}) / (2 * dz)
- * \partial_{xx} f = (f_{i+1} - 2 * f_i + f_{i-1}) / dx^2
- * \partial_{yy} f = (f_{j+1} - 2 * f_j + f_{j-1}) / dy^2
- * \partial_{zz} f = (f_{k+1} - 2 * f_k + f_{k-1}) / dz^2
- * \partial_{xy} f = (f_{i+1,j+1} - f_{i+1,j-1} - f_{i-1,j+1} + f_{i-1,j-1}) / (4 * dx * dy)
- * \partial_{xz} f = (f_{i+1,k+1} - f_{i+1,k-1} - f_{i-1,k+1} + f_{i-1,k-1}) / (4 * dx * dz)
- * \partial_{yz} f = (f_{j+1,k+1} - f_{j+1,k-1} - f_{j-1,k+1} + f_{j-1,k-1}) / (4 * dy * dz)
- * \partial_{xxy} f = (f_{i+2} - 2 * f_{i+1} + 2 * f_{i-1} - f_{i-2}) / (12 * dx)
- * \partial_{yyz} f = (f_{j+2} - 2 * f_{j+1} + 2 * f_{j-1} - f_{j-2}) / (12 * dy)
- * \partial_{zzx} f = (f_{k+2} - 2 * f_{k+1} + 2 * f_{k-1} - f_{k-2}) / (12 * dz)
- * \partial_{xxyy} f = (f_{i+1,j+1} - 2 * f_{i+1,j} + f_{i+1,j-1} - f_{i-1,j+1} + 2 * f_{i-1,j} - f_{i-1,j-1}) / (4 * dx * dy)
- * \partial_{yyzz} f = (f_{j+1,k+1} - 2 * f_{j+1,k} + f_{j+1,k-1} - f_{j-1,k+1} + 2 * f_{j-1,k} - f_{j-1,k-1}) / (4 * dy * dz)
- * \partial_{zzxx} f = (f_{k+1,i+1} - 2 * f_{k+1,i} + f_{k+1,i-1} - f_{k-1,i+1} + 2 * f_{k-1,i} - f_{k-1,i-1}) / (4 * dz * dx)
-* */
+ * Also here: the Kreiss-Oliger strength, the per-stage fill of the
+ * derivative cache and the startup report of its throughput.
+ * */
 
 
 
 
+/*
+ * Second derivatives of the lapse, second_partial() on the padded alpha
+ * array.
+ * */
 float partialXX_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i+1, j, k).gauge.alpha - 2.0 * grid_obj.getCell(i, j, k).gauge.alpha + grid_obj.getCell(i-1, j, k).gauge.alpha) 
-           / (DX * DX);
+    return second_partial(grid_obj, i, j, k, 0, 0, F_ALPHA);
 }
 
 float partialYY_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i, j+1, k).gauge.alpha - 2.0 * grid_obj.getCell(i, j, k).gauge.alpha + grid_obj.getCell(i, j-1, k).gauge.alpha) 
-           / (DY * DY);
+    return second_partial(grid_obj, i, j, k, 1, 1, F_ALPHA);
 }
 
 float partialZZ_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i, j, k+1).gauge.alpha - 2.0 * grid_obj.getCell(i, j, k).gauge.alpha + grid_obj.getCell(i, j, k-1).gauge.alpha) 
-           / (DZ * DZ);
+    return second_partial(grid_obj, i, j, k, 2, 2, F_ALPHA);
 }
 
 
 float partialXY_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i+1, j+1, k).gauge.alpha - grid_obj.getCell(i+1, j-1, k).gauge.alpha
-            - grid_obj.getCell(i-1, j+1, k).gauge.alpha + grid_obj.getCell(i-1, j-1, k).gauge.alpha)
-           / (4.0 * DX * DY);
+    return second_partial(grid_obj, i, j, k, 0, 1, F_ALPHA);
 }
 
 float partialXZ_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i+1, j, k+1).gauge.alpha - grid_obj.getCell(i+1, j, k-1).gauge.alpha
-            - grid_obj.getCell(i-1, j, k+1).gauge.alpha + grid_obj.getCell(i-1, j, k-1).gauge.alpha)
-           / (4.0 * DX * DZ);
+    return second_partial(grid_obj, i, j, k, 0, 2, F_ALPHA);
 }
 
 float partialYZ_alpha(Grid &grid_obj, int i, int j, int k) {
-    return (grid_obj.getCell(i, j+1, k+1).gauge.alpha - grid_obj.getCell(i, j+1, k-1).gauge.alpha
-            - grid_obj.getCell(i, j-1, k+1).gauge.alpha + grid_obj.getCell(i, j-1, k-1).gauge.alpha)
-           / (4.0 * DY * DZ);
+    return second_partial(grid_obj, i, j, k, 1, 2, F_ALPHA);
 }
 
 float second_partial_alpha(Grid &grid_obj, int i, int j, int k, int a, int b)
 {
-	if(a==0 && b==0) return partialXX_alpha(grid_obj, i, j, k);
-	if(a==1 && b==1) return partialYY_alpha(grid_obj, i, j, k);
-	if(a==2 && b==2) return partialZZ_alpha(grid_obj, i, j, k);
-
-	if((a==0 && b==1)||(a==1 && b==0)) return partialXY_alpha(grid_obj, i, j, k);
-	if((a==0 && b==2)||(a==2 && b==0)) return partialXZ_alpha(grid_obj, i, j, k);
-	if((a==1 && b==2)||(a==2 && b==1)) return partialYZ_alpha(grid_obj, i, j, k);
-
-	return 0.0;
+	return second_partial(grid_obj, i, j, k, a, b, F_ALPHA);
 }
 
 
 float GridTensor::partialX_gamma(Grid &grid_obj, int i, int j, int k, int a, int b) {
-    if (i >= 2 && i <= NX - 3) {
-        return fourth_order_diff(
-            grid_obj.getCell(i+2, j, k).geom.gamma[a][b],
-            grid_obj.getCell(i+1, j, k).geom.gamma[a][b],
-            grid_obj.getCell(i-1, j, k).geom.gamma[a][b],
-            grid_obj.getCell(i-2, j, k).geom.gamma[a][b],
-            DX 
-        );
-    } else if (i >= 1 && i <= NX - 2) {
-        return second_order_diff(
-            grid_obj.getCell(i+1, j, k).geom.gamma[a][b],
-            grid_obj.getCell(i-1, j, k).geom.gamma[a][b],
-            DX 
-        );
-    } else if (i == 0) {
-        return (grid_obj.getCell(i+1, j, k).geom.gamma[a][b] - 
-                grid_obj.getCell(i, j, k).geom.gamma[a][b]) / DX;
-    } else if (i == NX - 1) {
-        return (grid_obj.getCell(i, j, k).geom.gamma[a][b] - 
-                grid_obj.getCell(i-1, j, k).geom.gamma[a][b]) / DX;
-    }
-    return 0.0;
+    return line_d1([&](int q) { return grid_obj.getCell(q, j, k).geom.gamma[a][b]; }, i, grid_obj.nx, grid_obj.dx);
 }
 
 float GridTensor::partialY_gamma(Grid &grid_obj, int i, int j, int k, int a, int b) {
-    if (j >= 2 && j <= NY - 3) {
-        return fourth_order_diff(
-            grid_obj.getCell(i, j+2, k).geom.gamma[a][b],
-            grid_obj.getCell(i, j+1, k).geom.gamma[a][b],
-            grid_obj.getCell(i, j-1, k).geom.gamma[a][b],
-            grid_obj.getCell(i, j-2, k).geom.gamma[a][b],
-            DY
-        );
-    } else if (j >= 1 && j <= NY - 2) {
-        return second_order_diff(
-            grid_obj.getCell(i, j+1, k).geom.gamma[a][b],
-            grid_obj.getCell(i, j-1, k).geom.gamma[a][b],
-            DY
-        );
-    } else if (j == 0) {
-        return (grid_obj.getCell(i, j+1, k).geom.gamma[a][b] - 
-                grid_obj.getCell(i, j, k).geom.gamma[a][b]) / DY;
-    } else if (j == NY - 1) {
-        return (grid_obj.getCell(i, j, k).geom.gamma[a][b] - 
-                grid_obj.getCell(i, j-1, k).geom.gamma[a][b]) / DY;
-    }
-    return 0.0;
+    return line_d1([&](int q) { return grid_obj.getCell(i, q, k).geom.gamma[a][b]; }, j, grid_obj.ny, grid_obj.dy);
 }
 
 /*
  * The partial derivative of the metric tensor with respect to z
- * it uses a 2nd, fourth or sixth order finite difference scheme
+ * at FD_ORDER, with the FD closure at the ends of the line
  * */
 
 float GridTensor::partialZ_gamma(Grid &grid_obj, int i, int j, int k, int a, int b) {
-    if (k >= 2 && k <= NZ - 3) {
-        return fourth_order_diff(
-            grid_obj.getCell(i, j, k+2).geom.gamma[a][b],
-            grid_obj.getCell(i, j, k+1).geom.gamma[a][b],
-            grid_obj.getCell(i, j, k-1).geom.gamma[a][b],
-            grid_obj.getCell(i, j, k-2).geom.gamma[a][b],
-            DZ
-        );
-    } else if (k >= 1 && k <= NZ - 2) {
-        return second_order_diff(
-            grid_obj.getCell(i, j, k+1).geom.gamma[a][b],
-            grid_obj.getCell(i, j, k-1).geom.gamma[a][b],
-            DZ
-        );
-    } else if (k == 0) {
-        return (grid_obj.getCell(i, j, k+1).geom.gamma[a][b] - 
-                grid_obj.getCell(i, j, k).geom.gamma[a][b]) / DZ;
-    } else if (k == NZ - 1) {
-        return (grid_obj.getCell(i, j, k).geom.gamma[a][b] - 
-                grid_obj.getCell(i, j, k-1).geom.gamma[a][b]) / DZ;
-    }
-    return 0.0;
+    return line_d1([&](int q) { return grid_obj.getCell(i, j, q).geom.gamma[a][b]; }, k, grid_obj.nz, grid_obj.dz);
 }
 
 /*
- * these functions are used to compute the partial derivative of the extrinsic curvature tensor
- * and the Christoffel symbols, gauge.beta and gauge.alpha gauges conditions
- * All of these use a 2nd, fourth or sixth order finite difference scheme
- * it's working nicely but it's not optimized and probably not the best way to do it
- *
- * I'm currently working on a new method based on the spectral differentiation using Chebyshev polynomials
- * and the barycentric interpolation or the Lagrange interpolation (not sure yet)
+ * First derivatives of K_ij, FD::first() on the padded K arrays.
  * */
 
 
 float GridTensor::partialX_Kij(Grid &grid_obj, int i, int j, int k, int a, int b)
 {
 	/*
-	 * The fourth order difference is used when the point is not near the boundary
+	 * FD_ORDER everywhere: points near the boundary read the ghost
+	 * layers filled by Grid::fill_ghosts() instead of dropping order.
 	 * */
-	if (i >= 2 && i <= NX - 3) {
-		return fourth_order_diff(
-			grid_obj.getCell(i+2, j, k).curv.K[a][b],
-			grid_obj.getCell(i+1, j, k).curv.K[a][b],
-			grid_obj.getCell(i-1, j, k).curv.K[a][b],
-			grid_obj.getCell(i-2, j, k).curv.K[a][b],
-			DX 
-		);
-
-	/*
-	 * The second order difference is used when the point is near the boundary
-	 *  This is done to avoid the out of bounds error (boundary conditions are not implemented yet 
-	 *  exept for a Cell copy at the boundary, not really useful for now but it's a start)
-	 * */
-
-	} else if (i >= 1 && i <= NX - 2) {
-		return second_order_diff(
-			grid_obj.getCell(i+1, j, k).curv.K[a][b],
-			grid_obj.getCell(i-1, j, k).curv.K[a][b],
-			DX 
-		);
-		/*
-		 * The first order difference is used when the point is at the boundary
-		 * */
-	} else if (i == 0) {
-		return (grid_obj.getCell(i+1, j, k).curv.K[a][b] - 
-				grid_obj.getCell(i, j, k).curv.K[a][b]) / DX;
-	} else if (i == NX - 1) {
-		return (grid_obj.getCell(i, j, k).curv.K[a][b] - 
-				grid_obj.getCell(i-1, j, k).curv.K[a][b]) / DX;
-	}
-	return 0.0;
+	return partialX(grid_obj, i, j, k, F_K(a, b));
 }
 
 float GridTensor::partialY_Kij(Grid &grid_obj, int i, int j, int k, int a, int b)
 {
-	if (j >= 2 && j <= NY - 3) {
-		return fourth_order_diff(
-			grid_obj.getCell(i, j+2, k).curv.K[a][b],
-			grid_obj.getCell(i, j+1, k).curv.K[a][b],
-			grid_obj.getCell(i, j-1, k).curv.K[a][b],
-			grid_obj.getCell(i, j-2, k).curv.K[a][b],
-			DY
-		);
-	} else if (j >= 1 && j <= NY - 2) {
-		return second_order_diff(
-			grid_obj.getCell(i, j+1, k).curv.K[a][b],
-			grid_obj.getCell(i, j-1, k).curv.K[a][b],
-			DY
-		);
-	} else if (j == 0) {
-		return (grid_obj.getCell(i, j+1, k).curv.K[a][b] - 
-				grid_obj.getCell(i, j, k).curv.K[a][b]) / DY;
-	} else if (j == NY - 1) {
-		return (grid_obj.getCell(i, j, k).curv.K[a][b] - 
-				grid_obj.getCell(i, j-1, k).curv.K[a][b]) / DY;
-	}
-	return 0.0;
+	return partialY(grid_obj, i, j, k, F_K(a, b));
 }
 
 
 float GridTensor::partialZ_Kij(Grid &grid_obj, int i, int j, int k, int a, int b)
 {
-	if (k >= 2 && k <= NZ - 3) {
-		return fourth_order_diff(
-			grid_obj.getCell(i, j, k+2).curv.K[a][b],
-			grid_obj.getCell(i, j, k+1).curv.K[a][b],
-			grid_obj.getCell(i, j, k-1).curv.K[a][b],
-			grid_obj.getCell(i, j, k-2).curv.K[a][b],
-			DZ
-		);
-	} else if (k >= 1 && k <= NZ - 2) {
-		return second_order_diff(
-			grid_obj.getCell(i, j, k+1).curv.K[a][b],
-			grid_obj.getCell(i, j, k-1).curv.K[a][b],
-			DZ
-		);
-	} else if (k == 0) {
-		return (grid_obj.getCell(i, j, k+1).curv.K[a][b] - 
-				grid_obj.getCell(i, j, k).curv.K[a][b]) / DZ;
-	} else if (k == NZ - 1) {
-		return (grid_obj.getCell(i, j, k).curv.K[a][b] - 
-				grid_obj.getCell(i, j, k-1).curv.K[a][b]) / DZ;
-	}
-	return 0.0;
+	return partialZ(grid_obj, i, j, k, F_K(a, b));
 }
 
 
 
+
+float ko_dissipation_strength() {
+    const char *env = getenv("GRID_KO_SIGMA");
+    return env ? static_cast<float>(atof(env)) : static_cast<float>(KO_SIGMA);
+}
+
+/*
+ * One sweep per RK stage over the physical points: the FD_ORDER first
+ * derivative of every cached field along x, y and z, the Hessians of
+ * alpha and chi and the upwinded shift advection of every ADV_FIELD,
+ * written to the DerivativeCache by the pencil engine. The
+ * first derivatives use the same stencil as partialX/Y/Z on Field, so the
+ * cached and recomputed values agree bit for bit; the Hessians match
+ * second_partial() up to rounding. With GRID_COMPACT the first derivatives
+ * come from fill_compact_derivatives() instead. Rows come from
+ * for_each_row(), so with GRID_BRICK the sweep runs brick by brick.
+ * Orphaned worksharing, called by every thread of the evolve() region
+ * once the ghosts are up to date.
+ */
+template <typename D>
+void Grid::fill_derivative_cache() {
+    const int nx_ = D::nx(*this), ny_ = D::ny(*this), nz_ = D::nz(*this);
+    const float *const beta[3] = { storage.fields[F_BETA0], storage.fields[F_BETA1], storage.fields[F_BETA2] };
+
+#if GRID_COMPACT
+    fill_compact_derivatives<D>();
+#endif
+    for_each_row(0, nx_, 0, ny_, 0, nz_, [&](int i, int j, int kb, int ke) {
+#if !GRID_COMPACT
+        for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+            for (int dir = 0; dir < 3; dir++)
+                pencil_d1<D>(*this, storage.fields[f], dir, i, j, kb, ke, dcache.d[dir][f]);
+#endif
+        for (int h = 0; h < NUM_HESS_FIELDS; h++)
+            pencil_hessian<D>(*this, storage.fields[HESS_FIELD[h]], i, j, kb, ke, dcache.dd[h]);
+        for (int a = 0; a < NUM_ADV_FIELDS; a++)
+            pencil_advect<D>(*this, storage.fields[ADV_FIELD[a]], beta, i, j, kb, ke, dcache.adv[a]);
+    });
+    #pragma omp single
+    dcache.valid = true;
+}
+
+#define INSTANTIATE_DERIVATIVE_CACHE(N) \
+	template void Grid::fill_derivative_cache<GridDims<N>>();
+GRID_FAST_SIZES(INSTANTIATE_DERIVATIVE_CACHE)
+INSTANTIATE_DERIVATIVE_CACHE(0)
+
+/*
+ * Times one full first-derivative sweep over the cached fields two ways:
+ * point by point through partial_m() on Field, and row by row through
+ * pencil_d1(), both into the DerivativeCache, and prints the throughput
+ * of each in derivatives per second. The whole fill_derivative_cache()
+ * pass a stage runs (Hessians, advection terms and, with GRID_COMPACT,
+ * the compact solve on top) is timed on its own and reported per call,
+ * not folded into the first-derivative rate. Needs up to date ghosts.
+ * Leaves the cache invalid, the stage loop refills it.
+ */
+template <typename D>
+void Grid::report_derivative_throughput() {
+    const int nx_ = D::nx(*this), ny_ = D::ny(*this), nz_ = D::nz(*this);
+    const double nderiv = 3.0 * NUM_DERIV_FIELDS * nx_ * ny_ * nz_;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+#pragma omp parallel
+    for_each_row(0, nx_, 0, ny_, 0, nz_, [&](int i, int j, int kb, int ke) {
+        for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+            for (int dir = 0; dir < 3; dir++)
+                for (int k = kb; k < ke; k++)
+                    dcache.d[dir][f][D::offset(*this, i, j, k)] = partial_m<D>(*this, i, j, k, dir, Field(f));
+    });
+    auto t1 = std::chrono::high_resolution_clock::now();
+#pragma omp parallel
+    for_each_row(0, nx_, 0, ny_, 0, nz_, [&](int i, int j, int kb, int ke) {
+        for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+            for (int dir = 0; dir < 3; dir++)
+                pencil_d1<D>(*this, storage.fields[f], dir, i, j, kb, ke, dcache.d[dir][f]);
+    });
+    auto t2 = std::chrono::high_resolution_clock::now();
+#pragma omp parallel
+    fill_derivative_cache<D>();
+    auto t3 = std::chrono::high_resolution_clock::now();
+    dcache.valid = false;
+
+    const double point = std::chrono::duration<double>(t1 - t0).count();
+    const double pencil = std::chrono::duration<double>(t2 - t1).count();
+    const double fill = std::chrono::duration<double>(t3 - t2).count();
+    printf("First derivatives: pointwise %.3e /s, pencil %.3e /s (x%.2f)\n",
+           nderiv / point, nderiv / pencil, point / pencil);
+    printf("Derivative cache fill: %.3f ms (%s first derivatives, %d Hessians, %d advection terms)\n",
+           1e3 * fill, GRID_COMPACT ? "compact" : "pencil", NUM_HESS_FIELDS, NUM_ADV_FIELDS);
+}
+
+#define INSTANTIATE_DERIVATIVE_THROUGHPUT(N) \
+	template void Grid::report_derivative_throughput<GridDims<N>>();
+GRID_FAST_SIZES(INSTANTIATE_DERIVATIVE_THROUGHPUT)
+INSTANTIATE_DERIVATIVE_THROUGHPUT(0)
@@ -1,4 +1,389 @@
 #include "Spectral.h"
+#include <omp.h>
+#include <memory>
+
+/*
+ * Field geometry along one axis: outer slabs of n points of the axis, each
+ * point an inner run of contiguous values (1 along z).
+ */
+static void axis_geometry(const int n[3], int dim, int &outer, int &inner) {
+    outer = dim == 0 ? 1 : dim == 1 ? n[0] : n[0] * n[1];
+    inner = dim == 0 ? n[1] * n[2] : dim == 1 ? n[2] : 1;
+}
+
+#if GRID_SPECTRAL
+
+static const char *fftw_wisdom_file() {
+    const char *env = getenv("GRID_FFTW_WISDOM");
+    return env ? env : GRID_FFTW_WISDOM;
+}
+
+/*
+ * FFTW's thread pool is set up once, and the wisdom of earlier runs read
+ * before the first plan so FFTW_MEASURE can skip the shapes it has timed.
+ */
+static void fftw_setup() {
+    static bool done = false;
+    if (done)
+        return;
+    done = true;
+    fftwf_init_threads();
+    if (fftwf_import_wisdom_from_filename(fftw_wisdom_file()))
+        printf("FFTW wisdom loaded from %s\n", fftw_wisdom_file());
+}
+
+/*
+ * Plans are measured on the engine's own buffers, which FFTW_MEASURE
+ * overwrites, before anything is packed into them. The wisdom is written
+ * back right away so a run that dies later still saves its planning.
+ */
+SpectralDerivative::SpectralDerivative(int nx, int ny, int nz, float lx, float ly, float lz, int nbatch_)
+    : n{ nx, ny, nz }, nbatch(nbatch_), l{ lx, ly, lz } {
+    npts = static_cast<size_t>(nx) * ny * nz;
+    nspec = static_cast<size_t>(nx) * ny * (nz / 2 + 1);
+    bytes = nbatch * (npts * sizeof(float) + 2 * nspec * sizeof(fftwf_complex));
+
+    /* wavenumbers, scaled by 1 / npts for the unnormalised c2r */
+    for (int m = 0; m < 3; m++) {
+        const int len = m == 2 ? n[m] / 2 + 1 : n[m];
+        kw[m].resize(len);
+        for (int q = 0; q < len; q++) {
+            const int kq = (2 * q == n[m]) ? 0 : (q <= n[m] / 2 ? q : q - n[m]);
+            kw[m][q] = static_cast<float>(2.0 * M_PI * kq / l[m] / npts);
+        }
+    }
+
+    fftw_setup();
+    real = fftwf_alloc_real(nbatch * npts);
+    spec = fftwf_alloc_complex(nbatch * nspec);
+    work = fftwf_alloc_complex(nbatch * nspec);
+    if (!real || !spec || !work) {
+        fprintf(stderr, "Failed to allocate spectral buffers (%zu bytes)\n", bytes);
+        exit(1);
+    }
+    MemoryBudget::track(MEM_SPECTRAL, "spectral buffers", bytes);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    fftwf_plan_with_nthreads(omp_get_max_threads());
+    fwd = fftwf_plan_many_dft_r2c(3, n, nbatch, real, nullptr, 1, npts,
+                                  spec, nullptr, 1, nspec, FFTW_MEASURE);
+    bwd = fftwf_plan_many_dft_c2r(3, n, nbatch, work, nullptr, 1, nspec,
+                                  real, nullptr, 1, npts, FFTW_MEASURE);
+    if (!fwd || !bwd) {
+        fprintf(stderr, "FFTW planning failed for %dx%dx%d x %d\n", nx, ny, nz, nbatch);
+        exit(1);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    fftwf_export_wisdom_to_filename(fftw_wisdom_file());
+    printf("Spectral derivatives %dx%dx%d x %d fields: planned in %.3f s, %.2f MB\n",
+           nx, ny, nz, nbatch, std::chrono::duration<double>(t1 - t0).count(),
+           bytes / (1024.0 * 1024.0));
+}
+
+SpectralDerivative::~SpectralDerivative() {
+    fftwf_destroy_plan(fwd);
+    fftwf_destroy_plan(bwd);
+    fftwf_free(real);
+    fftwf_free(spec);
+    fftwf_free(work);
+    MemoryBudget::untrack(MEM_SPECTRAL, bytes);
+}
+
+/* one engine per shape, kept for the whole run so plans are never rebuilt */
+SpectralDerivative &SpectralDerivative::get(int nx, int ny, int nz, float lx, float ly, float lz, int nbatch) {
+    static std::vector<std::unique_ptr<SpectralDerivative>> engines;
+    for (auto &e : engines)
+        if (e->n[0] == nx && e->n[1] == ny && e->n[2] == nz && e->nbatch == nbatch
+            && e->l[0] == lx && e->l[1] == ly && e->l[2] == lz)
+            return *e;
+    engines.emplace_back(new SpectralDerivative(nx, ny, nz, lx, ly, lz, nbatch));
+    return *engines.back();
+}
+
+void SpectralDerivative::forward() {
+    fftwf_execute(fwd);
+}
+
+/* work = i k_m spec / npts, then c2r of the whole batch into real */
+void SpectralDerivative::backward(int m) {
+    const int nx = n[0], ny = n[1], nzc = n[2] / 2 + 1;
+    const float *kx = kw[0].data(), *ky = kw[1].data(), *kz = kw[2].data();
+    #pragma omp parallel for collapse(3)
+    for (int b = 0; b < nbatch; b++)
+        for (int i = 0; i < nx; i++)
+            for (int j = 0; j < ny; j++) {
+                const size_t row = b * nspec + (static_cast<size_t>(i) * ny + j) * nzc;
+                for (int q = 0; q < nzc; q++) {
+                    const float k = m == 0 ? kx[i] : m == 1 ? ky[j] : kz[q];
+                    const float re = spec[row + q][0], im = spec[row + q][1];
+                    work[row + q][0] = -k * im;
+                    work[row + q][1] = k * re;
+                }
+            }
+    fftwf_execute(bwd);
+}
+
+void SpectralDerivative::gradient(const float *const u[], float *const du[][3], int nf) {
+    for (int f0 = 0; f0 < nf; f0 += nbatch) {
+        const int nb = std::min(nbatch, nf - f0);
+        for (int b = 0; b < nb; b++)
+            memcpy(in(b), u[f0 + b], npts * sizeof(float));
+        forward();
+        for (int m = 0; m < 3; m++) {
+            bool wanted = false;
+            for (int b = 0; b < nb; b++)
+                wanted |= du[f0 + b][m] != nullptr;
+            if (!wanted)
+                continue;
+            backward(m);
+            for (int b = 0; b < nb; b++)
+                if (du[f0 + b][m])
+                    memcpy(du[f0 + b][m], out(b), npts * sizeof(float));
+        }
+    }
+}
+
+/*
+ * Accuracy and cost check on a smooth periodic field over the run's box,
+ * sin(2 pi x / Lx) cos(4 pi y / Ly) sin(2 pi z / Lz): max error of d_x and
+ * time per field, spectral against the FD_ORDER stencil wrapped around.
+ */
+void Grid::report_spectral_accuracy() {
+    const float L[3] = { nx * dx, ny * dy, nz * dz };
+    const float h[3] = { dx, dy, dz };
+    SpectralDerivative &sd = SpectralDerivative::get(nx, ny, nz, L[0], L[1], L[2], 1);
+    const size_t npts = sd.npts;
+    std::vector<float> u(npts), du(npts), exact(npts), fd(npts);
+    const double w[3] = { 2.0 * M_PI / L[0], 4.0 * M_PI / L[1], 2.0 * M_PI / L[2] };
+    for (int i = 0; i < nx; i++)
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++) {
+                const size_t p = (static_cast<size_t>(i) * ny + j) * nz + k;
+                const double x = i * h[0], y = j * h[1], z = k * h[2];
+                u[p] = sin(w[0] * x) * cos(w[1] * y) * sin(w[2] * z);
+                exact[p] = w[0] * cos(w[0] * x) * cos(w[1] * y) * sin(w[2] * z);
+            }
+
+    const float *uin[1] = { u.data() };
+    float *const dout[1][3] = { { du.data(), nullptr, nullptr } };
+    auto t0 = std::chrono::high_resolution_clock::now();
+    sd.gradient(uin, dout, 1);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    #pragma omp parallel for collapse(2)
+    for (int i = 0; i < nx; i++)
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++) {
+                auto at = [&](int s) {
+                    const int q = ((i + s) % nx + nx) % nx;
+                    return u[(static_cast<size_t>(q) * ny + j) * nz + k];
+                };
+                fd[(static_cast<size_t>(i) * ny + j) * nz + k] = FD::first(at, h[0]);
+            }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    double err_sp = 0.0, err_fd = 0.0;
+    for (size_t p = 0; p < npts; p++) {
+        err_sp = std::max(err_sp, (double)std::fabs(du[p] - exact[p]));
+        err_fd = std::max(err_fd, (double)std::fabs(fd[p] - exact[p]));
+    }
+    printf("Spectral d_x on a periodic wave: max error %.3e (order %d FD %.3e), "
+           "%.3f ms per field (FD %.3f ms)\n", err_sp, FD_ORDER, err_fd,
+           1e3 * std::chrono::duration<double>(t1 - t0).count(),
+           1e3 * std::chrono::duration<double>(t2 - t1).count());
+}
+
+/* the single-field form, on the engine cached for its shape */
+void spectral_derivative_3D(const std::vector<float> &f_in,
+                            std::vector<float> &f_out,
+                            int N_x, int N_y, int N_z,
+                            float dx, float dy, float dz,
+                            int dim)
+{
+    SpectralDerivative &sd = SpectralDerivative::get(N_x, N_y, N_z, N_x * dx, N_y * dy, N_z * dz, 1);
+    f_out.resize(sd.npts);
+    const float *u[1] = { f_in.data() };
+    float *const du[1][3] = { { dim == 0 ? f_out.data() : nullptr,
+                                dim == 1 ? f_out.data() : nullptr,
+                                dim == 2 ? f_out.data() : nullptr } };
+    sd.gradient(u, du, 1);
+}
+
+ChebyshevDCT::ChebyshevDCT(int nx, int ny, int nz, int dim_)
+    : n{ nx, ny, nz }, dim(dim_) {
+    npts = static_cast<size_t>(nx) * ny * nz;
+    bytes = npts * sizeof(float);
+    fftw_setup();
+    buf = fftwf_alloc_real(npts);
+    if (!buf) {
+        fprintf(stderr, "Failed to allocate Chebyshev buffer (%zu bytes)\n", bytes);
+        exit(1);
+    }
+    MemoryBudget::track(MEM_SPECTRAL, "Chebyshev buffer", bytes);
+
+    int outer, inner;
+    axis_geometry(n, dim, outer, inner);
+    const int len = n[dim];
+    fftwf_iodim line = { len, inner, inner };
+    fftwf_iodim lines[2] = { { outer, len * inner, len * inner }, { inner, 1, 1 } };
+    const fftwf_r2r_kind kind = FFTW_REDFT00;
+    fftwf_plan_with_nthreads(omp_get_max_threads());
+    dct = fftwf_plan_guru_r2r(1, &line, 2, lines, buf, buf, &kind, FFTW_MEASURE);
+    if (!dct) {
+        fprintf(stderr, "FFTW planning failed for DCT-I %dx%dx%d along %d\n", nx, ny, nz, dim);
+        exit(1);
+    }
+    fftwf_export_wisdom_to_filename(fftw_wisdom_file());
+}
+
+ChebyshevDCT::~ChebyshevDCT() {
+    fftwf_destroy_plan(dct);
+    fftwf_free(buf);
+    MemoryBudget::untrack(MEM_SPECTRAL, bytes);
+}
+
+ChebyshevDCT &ChebyshevDCT::get(int nx, int ny, int nz, int dim) {
+    static std::vector<std::unique_ptr<ChebyshevDCT>> engines;
+    for (auto &e : engines)
+        if (e->n[0] == nx && e->n[1] == ny && e->n[2] == nz && e->dim == dim)
+            return *e;
+    engines.emplace_back(new ChebyshevDCT(nx, ny, nz, dim));
+    return *engines.back();
+}
+
+/*
+ * With N = n - 1 and F = DCT-I(u), the Chebyshev coefficients are
+ * a_k = F_k / N (halved at k = 0, N); the derivative's follow from
+ * c_(k-1) b_(k-1) = b_(k+1) + 2 k a_k, and DCT-I(g) with g_0 = b_0,
+ * g_k = b_k / 2 evaluates sum_k b_k T_k back on the nodes. The map
+ * to [a, b] and 1 / N are folded into one scale.
+ */
+void ChebyshevDCT::derivative(const float *u, float *du, float a, float b) {
+    int outer, inner;
+    axis_geometry(n, dim, outer, inner);
+    const int N = n[dim] - 1;
+    const float scale = 2.0f / ((b - a) * N);
+
+    memcpy(buf, u, npts * sizeof(float));
+    fftwf_execute(dct);
+    #pragma omp parallel for collapse(2)
+    for (int o = 0; o < outer; o++)
+        for (int q = 0; q < inner; q++) {
+            float *c = buf + static_cast<size_t>(o) * (N + 1) * inner + q;
+            float bk1 = 0.0f, bk = 0.0f;	/* b_(k+1), b_k */
+            for (int k = N; k >= 1; k--) {
+                const float ak = c[k * inner] * scale * (k == N ? 0.5f : 1.0f);
+                const float bkm1 = bk1 + 2.0f * k * ak;
+                c[k * inner] = 0.5f * bk;
+                bk1 = bk;
+                bk = bkm1;
+            }
+            c[0] = 0.5f * bk;
+        }
+    fftwf_execute(dct);
+    memcpy(du, buf, npts * sizeof(float));
+}
+
+#endif
+
+/*
+ * Dense collocation along one axis: du[o][i][.] = sum_j D_ij u[o][j][.],
+ * with D flattened once per call and the inner run vectorised. O(n^2) per
+ * line, the cheaper choice for short lines.
+ */
+static void chebyshev_dense_3D(const float *u, float *du, const int n[3], float a, float b, int dim) {
+    int outer, inner;
+    axis_geometry(n, dim, outer, inner);
+    const int len = n[dim];
+    const auto nodes = ChebyshevSpectral::chebyshev_nodes(len, a, b);
+    const auto D = ChebyshevSpectral::chebyshev_diff_matrix(nodes);
+    std::vector<float> Df(static_cast<size_t>(len) * len);
+    for (int i = 0; i < len; i++)
+        for (int j = 0; j < len; j++)
+            Df[i * len + j] = D[i][j];
+
+    std::vector<float> tmp(u == du ? static_cast<size_t>(n[0]) * n[1] * n[2] : 0);
+    const float *src = u;
+    if (u == du) {
+        memcpy(tmp.data(), u, tmp.size() * sizeof(float));
+        src = tmp.data();
+    }
+    #pragma omp parallel for collapse(2)
+    for (int o = 0; o < outer; o++)
+        for (int i = 0; i < len; i++) {
+            float *out = du + (static_cast<size_t>(o) * len + i) * inner;
+            for (int q = 0; q < inner; q++)
+                out[q] = 0.0f;
+            for (int j = 0; j < len; j++) {
+                const float w = Df[i * len + j];
+                const float *in = src + (static_cast<size_t>(o) * len + j) * inner;
+                #pragma omp simd
+                for (int q = 0; q < inner; q++)
+                    out[q] += w * in[q];
+            }
+        }
+}
+
+void chebyshev_derivative_3D(const float *f_in, float *f_out,
+                             int N_x, int N_y, int N_z,
+                             float a, float b, int dim)
+{
+    const int n[3] = { N_x, N_y, N_z };
+#if GRID_SPECTRAL
+    if (n[dim] >= GRID_CHEB_DCT_MIN) {
+        ChebyshevDCT::get(N_x, N_y, N_z, dim).derivative(f_in, f_out, a, b);
+        return;
+    }
+#endif
+    chebyshev_dense_3D(f_in, f_out, n, a, b, dim);
+}
+
+#if GRID_SPECTRAL
+/*
+ * Check of the DCT-I Chebyshev path against the dense collocation product
+ * on p(x) = x^5 - 2 x^3 + x over [-1, 2], which both differentiate exactly
+ * at this many nodes: for each axis, GRID_CHEB_DCT_MIN + 1 nodes along it
+ * and 6 x 6 lines scaled differently across it. Prints the max error of
+ * each against p' and the time per field.
+ */
+void Grid::report_chebyshev_accuracy() {
+    const float a = -1.0f, b = 2.0f;
+    const int len = GRID_CHEB_DCT_MIN + 1;
+    for (int dim = 0; dim < 3; dim++) {
+        int n[3] = { 6, 6, 6 };
+        n[dim] = len;
+        int outer, inner;
+        axis_geometry(n, dim, outer, inner);
+        const auto nodes = ChebyshevSpectral::chebyshev_nodes(len, a, b);
+        const size_t npts = static_cast<size_t>(n[0]) * n[1] * n[2];
+        std::vector<float> u(npts), exact(npts), dct(npts), dense(npts);
+        for (int o = 0; o < outer; o++)
+            for (int i = 0; i < len; i++)
+                for (int q = 0; q < inner; q++) {
+                    const size_t p = (static_cast<size_t>(o) * len + i) * inner + q;
+                    const double x = nodes[i], s = 1.0 + 0.1 * (o * inner + q);
+                    u[p] = s * (((x * x - 2.0) * x * x + 1.0) * x);
+                    exact[p] = s * ((5.0 * x * x - 6.0) * x * x + 1.0);
+                }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        ChebyshevDCT::get(n[0], n[1], n[2], dim).derivative(u.data(), dct.data(), a, b);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        chebyshev_dense_3D(u.data(), dense.data(), n, a, b, dim);
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        double err_dct = 0.0, err_dense = 0.0, scale = 0.0;
+        for (size_t p = 0; p < npts; p++) {
+            err_dct = std::max(err_dct, (double)std::fabs(dct[p] - exact[p]));
+            err_dense = std::max(err_dense, (double)std::fabs(dense[p] - exact[p]));
+            scale = std::max(scale, (double)std::fabs(exact[p]));
+        }
+        printf("Chebyshev d/dx along %d, %d nodes: DCT-I max error %.3e, dense %.3e (|p'| <= %.1f), "
+               "%.3f ms per field (dense %.3f ms)\n", dim, len, err_dct, err_dense, scale,
+               1e3 * std::chrono::duration<double>(t1 - t0).count(),
+               1e3 * std::chrono::duration<double>(t2 - t1).count());
+    }
+}
+#endif
 
 /*
  * This function compute Partial derivative using spectral methods
@@ -13,66 +398,6 @@
  *
  * */
 
-/* void spectral_derivative_3D(const std::vector<float> &f_in, */
-/*                             std::vector<float> &f_out, */
-/*                             int N_x, int N_y, int N_z, */
-/*                             float dx, float dy, float dz, */
-/*                             int dim) */
-/* { */
-/*     int N = N_x * N_y * N_z; */
-/*     fftw_complex *in  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N); */
-/*     fftw_complex *out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * N); */
-/*  */
-/*     for (int i = 0; i < N; i++) { */
-/*         in[i][0] = f_in[i]; // réel */
-/*         in[i][1] = 0.0;     // imag */
-/*     } */
-/*  */
-/*     fftw_plan plan_forward  = fftw_plan_dft_3d(N_x, N_y, N_z, in, out, FFTW_FORWARD,  FFTW_ESTIMATE); */
-/*     fftw_plan plan_backward = fftw_plan_dft_3d(N_x, N_y, N_z, out, in, FFTW_BACKWARD, FFTW_ESTIMATE); */
-/*  */
-/*     // FFT directe 3D */
-/*     fftw_execute(plan_forward); */
-/*  */
-/*     for (int ix = 0; ix < N_x; ix++) { */
-/*         int kx = (ix <= N_x/2) ? ix : ix - N_x; */
-/*         float fx = 2.0 * M_PI * kx / (N_x * dx); */
-/*  */
-/*         for (int iy = 0; iy < N_y; iy++) { */
-/*             int ky = (iy <= N_y/2) ? iy : iy - N_y; */
-/*             float fy = 2.0 * M_PI * ky / (N_y * dy); */
-/*  */
-/*             for (int iz = 0; iz < N_z; iz++) { */
-/*                 int kz = (iz <= N_z/2) ? iz : iz - N_z; */
-/*                 float fz = 2.0 * M_PI * kz / (N_z * dz); */
-/*  */
-/*                 int index = (ix*(N_y*N_z)) + (iy*N_z) + iz; */
-/*                 float real = out[index][0]; */
-/*                 float imag = out[index][1]; */
-/*  */
-/*                 float factor = 0.0; */
-/*                 if      (dim == 0) factor = fx;   */
-/*                 else if (dim == 1) factor = fy;   */
-/*                 else if (dim == 2) factor = fz;   */
-/*  */
-/*                 out[index][0] = -factor * imag; */
-/*                 out[index][1] =  factor * real;  */
-/*             } */
-/*         } */
-/*     } */
-/*  */
-/*     fftw_execute(plan_backward); */
-/*  */
-/*     for (int i = 0; i < N; i++) { */
-/*         f_out[i] = in[i][0] / float(N); */
-/*     } */
-/*  */
-/*     fftw_destroy_plan(plan_forward); */
-/*     fftw_destroy_plan(plan_backward); */
-/*     fftw_free(in); */
-/*     fftw_free(out); */
-/* } */
-/*  */
 /* std::vector<float> computeBaryWeights(const std::vector<float>& nodes) { */
 /*     int N = nodes.size(); */
 /*     std::vector<float> weights(N, 1.0); */
@@ -12,18 +12,21 @@ public:
         return nodes;
     }
 
-    static std::vector<std::vector<float>> chebyshev_diff_matrix(const std::vector<float>& nodes, float a, float b) {
+    /*
+     * The nodes are already mapped to their interval, so 1 / (x_i - x_j)
+     * carries the 2 / (b - a) of the map and D is d/dx there as it stands.
+     */
+    static std::vector<std::vector<float>> chebyshev_diff_matrix(const std::vector<float>& nodes) {
         int N = nodes.size();
         std::vector<std::vector<float>> D(N, std::vector<float>(N, 0.0));
         std::vector<float> c(N, 1.0);
         c[0] = 2.0;
         c[N - 1] = 2.0;
-        float factor = 2.0 / (b - a);
         
         for (int i = 0; i < N; ++i) {
             for (int j = 0; j < N; ++j) {
                 if (i != j) {
-                    D[i][j] = factor * (c[i] / c[j]) * pow(-1, i + j) / (nodes[i] - nodes[j]);
+                    D[i][j] = (c[i] / c[j]) * pow(-1, i + j) / (nodes[i] - nodes[j]);
                 }
             }
         }
@@ -1,14 +1,14 @@
 #include <Geodesics.h>
 
 void Grid::compute_gauge_derivatives(Grid &grid_obj, int i, int j, int k, float &d_alpha_dt, float d_beta_dt[3]) {
-    Grid::Cell2D &cell = globalGrid[i][j][k];
+    Grid::Cell2D &cell = getCell(i, j, k);
     float gammaLocal[3][3], KLocal[3][3];
 	GridTensor gridTensor;
     float gammaInv[3][3];
     for (int a = 0; a < 3; a++) {
         for (int b = 0; b < 3; b++) {
             gammaLocal[a][b] = cell.geom.gamma[a][b];
-            KLocal[a][b]     = cell.curv.K[a][b];
+            KLocal[a][b]     = at(F_K(a, b), i, j, k);
 			gammaInv[a][b] = cell.geom.gamma_inv[a][b];	
         }
     }
@@ -20,9 +20,9 @@ void Grid::compute_gauge_derivatives(Grid &grid_obj, int i, int j, int k, float
 		}
     }
 
-    d_alpha_dt = -2.0 * cell.gauge.alpha * Ktrace ;
+    d_alpha_dt = -2.0 * at(F_ALPHA, i, j, k) * Ktrace ;
 
-    float eta = 2.0 / (1.0 + std::fabs(Ktrace));
+    float eta = shift_damping(i, j, k);
     float d_Gamma_dt[3] = {0.0, 0.0, 0.0}; 
 
     float tildeGamma[3];
@@ -30,7 +30,7 @@ void Grid::compute_gauge_derivatives(Grid &grid_obj, int i, int j, int k, float
     gridTensor.compute_dt_tildeGamma(grid_obj, i, j, k, d_Gamma_dt);
 
     for (int m = 0; m < 3; m++) {
-        d_beta_dt[m] = 3.0 / 4.0 * d_Gamma_dt[m] - eta * cell.gauge.beta[m];
+        d_beta_dt[m] = 3.0 / 4.0 * d_Gamma_dt[m] - eta * at(F_BETA(m), i, j, k);
 	}
 	cell.gauge.dt_alpha = d_alpha_dt;
 	for (int m = 0; m < 3; m++) {
@@ -38,3 +38,18 @@ void Grid::compute_gauge_derivatives(Grid &grid_obj, int i, int j, int k, float
 	}
 }
 
+
+/*
+ * eta of the Gamma-driver shift condition at a point, 2 / (1 + |K|) with
+ * the trace taken through the inverse metric of the last RHS evaluation.
+ * The one definition: compute_gauge_derivatives() damps with it and the
+ * IMEX split of the method-of-lines driver treats the same term implicitly.
+ */
+float Grid::shift_damping(int i, int j, int k) const {
+    const Cell2D &cell = getCell(i, j, k);
+    float Ktrace = 0.0;
+    for (int a = 0; a < 3; a++)
+        for (int b = 0; b < 3; b++)
+            Ktrace += cell.geom.gamma_inv[a][b] * at(F_K(a, b), i, j, k);
+    return 2.0 / (1.0 + std::fabs(Ktrace));
+}
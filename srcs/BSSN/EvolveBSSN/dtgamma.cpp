@@ -1,19 +1,20 @@
 #include <Geodesics.h>
 
 void BSSNevolve::compute_dt_tilde_gamma(Grid &grid_obj, int i, int j, int k, float dt_tg[3][3]) {
-    const auto &cell = grid_obj.getCell(i, j, k);
-    const float alpha = cell.gauge.alpha;
+    const float alpha = grid_obj.at(F_ALPHA, i, j, k);
 
-    const float* beta = cell.gauge.beta;
-    const auto& tg = cell.geom.tilde_gamma;
+    float beta[3], tg[3][3];
+    for (int a = 0; a < 3; ++a) {
+        beta[a] = grid_obj.at(F_BETA(a), i, j, k);
+        for (int b = 0; b < 3; ++b)
+            tg[a][b] = grid_obj.at(F_GT(a, b), i, j, k);
+    }
 
     float d_tg[3][3][3]; 
     for (int dir = 0; dir < 3; ++dir) {
         for (int a = 0; a < 3; ++a) {
             for (int b = 0; b < 3; ++b) {
-                d_tg[dir][a][b] = partial_m(grid_obj, i, j, k, dir, [&](const Grid::Cell2D &c) {
-                    return c.geom.tilde_gamma[a][b];
-                });
+                d_tg[dir][a][b] = partial_m(grid_obj, i, j, k, dir, F_GT(a, b));
             }
         }
     }
@@ -21,9 +22,7 @@ void BSSNevolve::compute_dt_tilde_gamma(Grid &grid_obj, int i, int j, int k, flo
     float d_beta[3][3]; // j, k
     for (int j_idx = 0; j_idx < 3; ++j_idx) {
         for (int k_idx = 0; k_idx < 3; ++k_idx) {
-            d_beta[j_idx][k_idx] = partial_m(grid_obj, i, j, k, j_idx, [&](const Grid::Cell2D &c) {
-                return c.gauge.beta[k_idx];
-            });
+            d_beta[j_idx][k_idx] = partial_m(grid_obj, i, j, k, j_idx, F_BETA(k_idx));
         }
     }
 
@@ -41,7 +40,7 @@ void BSSNevolve::compute_dt_tilde_gamma(Grid &grid_obj, int i, int j, int k, flo
 
     for (int a = 0; a < 3; ++a) {
         for (int b = 0; b < 3; ++b) {
-            dt_tg[a][b] = -2.0 * alpha * cell.atilde.Atilde[a][b] + Lie[a][b];
+            dt_tg[a][b] = -2.0 * alpha * grid_obj.at(F_AT(a, b), i, j, k) + Lie[a][b];
         }
     }
 }
@@ -0,0 +1,135 @@
+#include <Geodesics.h>
+
+/*
+ * Allocation bookkeeping. Owners call track()/untrack() from serial code
+ * (allocation never happens inside the evolve() parallel region), so plain
+ * counters are enough.
+ */
+size_t MemoryBudget::held[MEM_NSUB] = {};
+size_t MemoryBudget::peakBytes = 0;
+
+static inline double mb(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+const char *MemoryBudget::name(MemSubsystem sub) {
+    static const char *names[MEM_NSUB] = {
+        "grid", "rk registers", "derivative cache", "constraints", "elliptic",
+        "spectral"
+    };
+    return names[sub];
+}
+
+void MemoryBudget::track(MemSubsystem sub, const char *what, size_t bytes) {
+    held[sub] += bytes;
+    peakBytes = std::max(peakBytes, current());
+    const size_t limit = budget();
+    if (limit && current() > limit)
+        printf("Memory budget exceeded by %s: %.2f MB held, budget %.2f MB\n",
+               what, mb(current()), mb(limit));
+}
+
+void MemoryBudget::untrack(MemSubsystem sub, size_t bytes) {
+    held[sub] -= std::min(held[sub], bytes);
+}
+
+size_t MemoryBudget::current() {
+    size_t total = 0;
+    for (int s = 0; s < MEM_NSUB; s++)
+        total += held[s];
+    return total;
+}
+
+size_t MemoryBudget::peak() {
+    return peakBytes;
+}
+
+size_t MemoryBudget::budget() {
+    const char *env = getenv("GRID_MEM_BUDGET_MB");
+    const double budget_mb = env ? atof(env) : GRID_MEM_BUDGET_MB;
+    return budget_mb > 0 ? static_cast<size_t>(budget_mb * 1024.0 * 1024.0) : 0;
+}
+
+void MemoryBudget::report() {
+    printf("Memory held by subsystem:\n");
+    for (int s = 0; s < MEM_NSUB; s++)
+        printf("  %-18s %10.2f MB\n", name(MemSubsystem(s)), mb(held[s]));
+    printf("  %-18s %10.2f MB (peak %.2f MB)\n", "total", mb(current()), mb(peakBytes));
+}
+
+size_t nested_vector_bytes(int nx, int ny, int nz) {
+    return static_cast<size_t>(nx) * ny * nz * sizeof(float)
+         + static_cast<size_t>(nx) * ny * sizeof(std::vector<float>)
+         + static_cast<size_t>(nx) * sizeof(std::vector<std::vector<float>>)
+         + sizeof(std::vector<std::vector<std::vector<float>>>);
+}
+
+/*
+ * Projected footprint of an nx*ny*nz run with the current build options,
+ * from the same sizers the allocators use. Initial data holds the grid and
+ * the Lichnerowicz psi; the evolution holds the grid, hamiltonianGrid, the
+ * RK registers and the derivative cache. Returns the larger of the two.
+ * verbose prints the per-subsystem and per-field breakdown.
+ */
+size_t Grid::memory_plan(int nx_, int ny_, int nz_, bool verbose) {
+    const size_t npts = static_cast<size_t>(padded_extent(nx_, GHOST)) * padded_extent(ny_, GHOST)
+                      * padded_extent(nz_, GHOST);
+    const size_t grid = GridStorage::bytes_for(nx_, ny_, nz_, GHOST, GRID_HUGEPAGES);
+    const size_t regs = StageRegisters::bytes_for(npts, RK_NREGS, GRID_HUGEPAGES);
+    const size_t cache = GRID_DERIV_CACHE ? DerivativeCache::bytes_for(npts, GRID_HUGEPAGES) : 0;
+    const size_t ham = nested_vector_bytes(nx_, ny_, nz_);
+    const size_t psi = nested_vector_bytes(nx_, ny_, nz_);
+    const size_t init_phase = grid + psi;
+    const size_t evolve_phase = grid + ham + regs + cache;
+    const size_t peak = std::max(init_phase, evolve_phase);
+
+    if (!verbose)
+        return peak;
+
+    printf("Memory plan for %dx%dx%d (%zu padded points):\n", nx_, ny_, nz_, npts);
+    printf("  %-18s %10.2f MB\n", MemoryBudget::name(MEM_GRID), mb(grid));
+    printf("  %-18s %10.2f MB\n", MemoryBudget::name(MEM_RK), mb(regs));
+    printf("  %-18s %10.2f MB\n", MemoryBudget::name(MEM_DERIV_CACHE), mb(cache));
+    printf("  %-18s %10.2f MB\n", MemoryBudget::name(MEM_CONSTRAINTS), mb(ham));
+    printf("  %-18s %10.2f MB (initial data only)\n", MemoryBudget::name(MEM_ELLIPTIC), mb(psi));
+    printf("  projected peak     %10.2f MB (initial data %.2f MB, evolution %.2f MB)\n",
+           mb(peak), mb(init_phase), mb(evolve_phase));
+
+    struct { const char *name; size_t bytes; } cell_parts[] = {
+        { "geom",   sizeof(Geometry) },
+        { "conn",   sizeof(Connection) },
+        { "curv",   sizeof(ExtrinsicCurvature) },
+        { "atilde", sizeof(AtildeVars) },
+        { "gauge",  sizeof(Gauge) },
+        { "matter", sizeof(Matter) },
+        { "dgt",    sizeof(Sym3) },
+    };
+    printf("  Cell2D, %zu bytes per point:\n", sizeof(Cell2D));
+    for (const auto &part : cell_parts)
+        printf("    %-16s %6zu B/pt %10.2f MB\n", part.name, part.bytes, mb(part.bytes * npts));
+
+    static const char *field_names[NUM_FIELDS] = {
+        "alpha", "beta0", "beta1", "beta2", "chi",
+        "gt_xx", "gt_xy", "gt_xz", "gt_yy", "gt_yz", "gt_zz",
+        "At_xx", "At_xy", "At_xz", "At_yy", "At_yz", "At_zz",
+        "K_xx",  "K_xy",  "K_xz",  "K_yy",  "K_yz",  "K_zz"
+    };
+    const size_t field_bytes = npts * sizeof(float);
+    printf("  evolved fields, %.2f MB each, x1 grid + x%d RK registers%s:\n",
+           mb(field_bytes), (int)RK_NREGS,
+           GRID_DERIV_CACHE ? " (+ x3 cached derivatives, x6 Hessians, x1 advection)" : "");
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        int copies = 1 + RK_NREGS + ((GRID_DERIV_CACHE && f < NUM_DERIV_FIELDS) ? 3 : 0);
+        for (int h = 0; h < NUM_HESS_FIELDS; h++)
+            if (GRID_DERIV_CACHE && f == HESS_FIELD[h])
+                copies += SYM_NCOMP;
+        for (int a = 0; a < NUM_ADV_FIELDS; a++)
+            if (GRID_DERIV_CACHE && f == ADV_FIELD[a])
+                copies += 1;
+        printf("    %-16s x%d %10.2f MB\n", field_names[f], copies, mb(copies * field_bytes));
+    }
+    const size_t limit = MemoryBudget::budget();
+    if (limit)
+        printf("  budget             %10.2f MB\n", mb(limit));
+    return peak;
+}
@@ -17,7 +17,7 @@ static inline float kerrSchildRadius(float x, float y, float z, float a)
     return std::sqrt(term);
 }
 
-void Grid::injectTTWave(Cell2D &cell, float x, float y, float z, float t){
+void Grid::injectTTWave(int i0, int j0, int k0, float x, float y, float z, float t){
 	constexpr float A      = 1.6; 
 	constexpr float lambda = 3.0; 
 	constexpr float r0     = 2.0;
@@ -61,7 +61,7 @@ void Grid::injectTTWave(Cell2D &cell, float x, float y, float z, float t){
 
 	for (int i = 0; i < 3; ++i)
 		for (int j = 0; j < 3; ++j)
-			cell.geom.tilde_gamma[i][j] += h_cartesian[i][j];
+			at(F_GT(i, j), i0, j0, k0) += h_cartesian[i][j];
 
 	float dh_plus_dt  = -omega * A / r * std::sin(phase) * envelope;
 	float dh_cross_dt = -omega * A / r * std::cos(phase) * envelope;
@@ -70,7 +70,7 @@ void Grid::injectTTWave(Cell2D &cell, float x, float y, float z, float t){
 		for (int j = 0; j < 3; ++j) {
 			float dh_ij_dt = dh_plus_dt * (e_theta[i] * e_theta[j] - e_phi[i] * e_phi[j])
 				+ dh_cross_dt * (e_theta[i] * e_phi[j] + e_phi[i] * e_theta[j]);
-			cell.atilde.Atilde[i][j] += -0.5 / cell.gauge.alpha * dh_ij_dt;
+			at(F_AT(i, j), i0, j0, k0) += -0.5 / at(F_ALPHA, i0, j0, k0) * dh_ij_dt;
 		}
 }
 
@@ -93,13 +93,15 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
     float eta  = m1 * m2 / (m1 + m2);
     float v_orb = std::sqrt((m1 + m2)/r12) * (1.0 + (3.0 - eta)/r12);
 
-    float dx = (x_max - x_min) / (NX - 1);
-    float dy = (y_max - y_min) / (NY - 1);
-    float dz = (z_max - z_min) / (NZ - 1);
+    float dx = (x_max - x_min) / (nx - 1);
+    float dy = (y_max - y_min) / (ny - 1);
+    float dz = (z_max - z_min) / (nz - 1);
 
     GridTensor gridtensor;
     Matrix matrix;
-    globalGrid.resize(NX, std::vector<std::vector<Cell2D>>(NY, std::vector<Cell2D>(NZ)));
+    if (!storage.cells) {
+        allocateGlobalGrid();
+    }
 
     
 	auto lorentz_boost_lmu = [](float beta, float lt, float lx, float ly, float lz) {
@@ -110,9 +112,9 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
 	};
 
     #pragma omp parallel for collapse(3) schedule(dynamic)
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < nx; i++) {
+        for (int j = 0; j < ny; j++) {
+            for (int k = 0; k < nz; k++) {
                 float x = x_min + i * dx;
                 float y = y_min + j * dy;
                 float z = z_min + k * dz;
@@ -150,7 +152,7 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
                     ly /= norm_l;
                     lz /= norm_l;
                 }
-                Cell2D &cell = globalGrid[i][j][k];
+                Cell2D &cell = getCell(i, j, k);
 
                 cell.geom.gamma[0][0] = 1.0 + 2.0 * H * lx * lx;
                 cell.geom.gamma[0][1] = 2.0 * H * lx * ly;
@@ -165,50 +167,51 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
                 matrix.inverse_3x3(cell.geom.gamma, cell.geom.gamma_inv);
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        cell.geom.tilde_gamma[a][b] = cell.geom.gamma[a][b];
+                        at(F_GT(a, b), i, j, k) = cell.geom.gamma[a][b];
 
                 Matrix3x3 tg_std, inv_tg_std;
                 for (int a = 0; a < 3; ++a)
                     for (int b = 0; b < 3; ++b)
-                        tg_std[a][b] = cell.geom.tilde_gamma[a][b];
+                        tg_std[a][b] = at(F_GT(a, b), i, j, k);
                 matrix.inverse_3x3(tg_std, inv_tg_std);
                 for (int a = 0; a < 3; ++a)
                     for (int b = 0; b < 3; ++b)
-                        cell.geom.tildgamma_inv[a][b] = inv_tg_std[a][b];
+                        cell.geom.tildgamma_inv(a, b) = inv_tg_std[a][b];
 
-                cell.gauge.alpha = 1.0 / std::sqrt(1.0 + 2.0 * H);
-                cell.gauge.beta[0] = 2.0 * H * lx;
-                cell.gauge.beta[1] = 2.0 * H * ly;
-                cell.gauge.beta[2] = 2.0 * H * lz;
+                at(F_ALPHA, i, j, k) = 1.0 / std::sqrt(1.0 + 2.0 * H);
+                at(F_BETA0, i, j, k) = 2.0 * H * lx;
+                at(F_BETA1, i, j, k) = 2.0 * H * ly;
+                at(F_BETA2, i, j, k) = 2.0 * H * lz;
 
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        cell.curv.K[a][b] = 0.0;
+                        at(F_K(a, b), i, j, k) = 0.0;
             }
         }
     }
+    fill_ghosts();
 
 
 	BSSNevolve bssn;
-	for (int i = 1; i < NX - 1; i++) {
-		for (int j = 1; j < NY - 1; j++) {
-			for (int k = 1; k < NZ - 1; k++) {
+	for (int i = 1; i < nx - 1; i++) {
+		for (int j = 1; j < ny - 1; j++) {
+			for (int k = 1; k < nz - 1; k++) {
 				for (int a = 0; a < 3; ++a) {
 					for (int b = 0; b < 3; ++b) {
-						globalGrid[i][j][k].dgt[a][b] = 0.0;  // dt_tilde_gamma = 0
+						getCell(i, j, k).dgt(a, b) = 0.0;  // dt_tilde_gamma = 0
 					}
 				}		
 				gridtensor.compute_extrinsic_curvature(*this, i, j, k, dx, dy, dz);
 				gridtensor.compute_Atilde(*this, i, j, k);
 
-				Cell2D &cell = globalGrid[i][j][k];
+				Cell2D &cell = getCell(i, j, k);
 				float Ktrace = 0.0;
 				for (int a = 0; a < 3; a++)
 					for (int b = 0; b < 3; b++)
-						Ktrace += cell.geom.tildgamma_inv[a][b] * cell.curv.K[a][b];
+						Ktrace += cell.geom.tildgamma_inv(a, b) * at(F_K(a, b), i, j, k);
 				for (int a = 0; a < 3; a++)
 					for (int b = 0; b < 3; b++)
-						cell.atilde.Atilde[a][b] = cell.chi * (cell.curv.K[a][b] - (1.0 / 3.0) * Ktrace * cell.geom.tilde_gamma[a][b]);
+						at(F_AT(a, b), i, j, k) = at(F_CHI, i, j, k) * (at(F_K(a, b), i, j, k) - (1.0 / 3.0) * Ktrace * at(F_GT(a, b), i, j, k));
 			}
 		}
 	}
@@ -219,22 +222,22 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
 	int max_iter = 5000;
 	float tol = 1e-8;
 	solve_lichnerowicz(max_iter, tol, dx, dy, dz);
-	printf("Chi = %f\n", globalGrid[1][1][1].chi);
-	for (int i = 1; i < NX - 1; i++) {
-		for (int j = 1; j < NY - 1; j++) {
-			for (int k = 1; k < NZ - 1; k++) {
-				Cell2D &cell = globalGrid[i][j][k];
+	printf("Chi = %f\n", at(F_CHI, 1, 1, 1));
+	for (int i = 1; i < nx - 1; i++) {
+		for (int j = 1; j < ny - 1; j++) {
+			for (int k = 1; k < nz - 1; k++) {
+				Cell2D &cell = getCell(i, j, k);
 				for (int a = 0; a < 3; a++)
 					for (int b = 0; b < 3; b++)
-						cell.geom.tilde_gamma[a][b] = cell.chi * cell.geom.gamma[a][b];
+						at(F_GT(a, b), i, j, k) = at(F_CHI, i, j, k) * cell.geom.gamma[a][b];
 				Matrix3x3 tg_std, inv_tg_std;
 				for (int a = 0; a < 3; ++a)
 					for (int b = 0; b < 3; ++b)
-						tg_std[a][b] = cell.geom.tilde_gamma[a][b];
+						tg_std[a][b] = at(F_GT(a, b), i, j, k);
 				matrix.inverse_3x3(tg_std, inv_tg_std);
 				for (int a = 0; a < 3; ++a)
 					for (int b = 0; b < 3; ++b)
-						cell.geom.tildgamma_inv[a][b] = inv_tg_std[a][b];
+						cell.geom.tildgamma_inv(a, b) = inv_tg_std[a][b];
 			}
 		}
 	}
@@ -242,7 +245,7 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
     for (int p = 0; p < 3; p++) {
         printf("  ");
         for (int q = 0; q < 3; q++) {
-            printf("%e ", globalGrid[1][1][1].curv.K[p][q]);
+            printf("%e ", at(F_K(p, q), 1, 1, 1));
         }
         printf("\n");
     }
@@ -250,12 +253,12 @@ void Grid::initializeBinaryKerrData(Grid &grid_obj) {
     for (int p = 0; p < 3; p++) {
         printf("  ");
         for (int q = 0; q < 3; q++) {
-            printf("%e ", globalGrid[1][1][1].geom.gamma[p][q]);
+            printf("%e ", getCell(1, 1, 1).geom.gamma[p][q]);
         }
         printf("\n");
     }
-    printf("chi near (1,1,1) = %e\n", globalGrid[1][1][1].chi);
-    printf("alpha_1_1_1 = %e\n", globalGrid[1][1][1].gauge.alpha);
+    printf("chi near (1,1,1) = %e\n", at(F_CHI, 1, 1, 1));
+    printf("alpha_1_1_1 = %e\n", at(F_ALPHA, 1, 1, 1));
     
     float test_radii[] = {0.5, 1.0, 2.0, 5.0, 10.0};
     for (float test_r : test_radii) {
@@ -2,8 +2,9 @@
 
 
 void Grid::solve_lichnerowicz(int max_iter, float tol, float dx, float dy, float dz) {
-    std::vector<std::vector<std::vector<float>>> psi(NX,
-        std::vector<std::vector<float>>(NY, std::vector<float>(NZ, 1.0)));
+    std::vector<std::vector<std::vector<float>>> psi(nx,
+        std::vector<std::vector<float>>(ny, std::vector<float>(nz, 1.0)));
+    MemoryBudget::track(MEM_ELLIPTIC, "Lichnerowicz psi", nested_vector_bytes(nx, ny, nz));
 
     const float inv_dx2 = 1.0/(dx*dx), inv_dy2 = 1.0/(dy*dy), inv_dz2 = 1.0/(dz*dz);
     const float factor = 1.0 / (2.0*(inv_dx2 + inv_dy2 + inv_dz2));
@@ -13,21 +14,22 @@ void Grid::solve_lichnerowicz(int max_iter, float tol, float dx, float dy, float
 
 
         #pragma omp parallel for collapse(3) reduction(max:max_diff)
-        for (int i = 1; i < NX - 1; ++i) {
-            for (int j = 1; j < NY - 1; ++j) {
-                for (int k = 1; k < NZ - 1; ++k) {
+        for (int i = 1; i < nx - 1; ++i) {
+            for (int j = 1; j < ny - 1; ++j) {
+                for (int k = 1; k < nz - 1; ++k) {
                     float lap = inv_dx2*(psi[i+1][j][k] + psi[i-1][j][k] - 2.0*psi[i][j][k])
                                 + inv_dy2*(psi[i][j+1][k] + psi[i][j-1][k] - 2.0*psi[i][j][k])
                                 + inv_dz2*(psi[i][j][k+1] + psi[i][j][k-1] - 2.0*psi[i][j][k]);
 
-                    Cell2D &cell = globalGrid[i][j][k];
+                    Cell2D &cell = getCell(i, j, k);
+                    const size_t n = idx(i, j, k);
 					float A2 = 0.0;
 					for (int a = 0; a < 3; ++a) {
 						for (int b = 0; b < 3; ++b) {
 							for (int c = 0; c < 3; ++c) {
 								for (int d = 0; d < 3; ++d) {
-									A2 += cell.geom.tildgamma_inv[a][c] * cell.geom.tildgamma_inv[b][d] 
-										* cell.atilde.Atilde[c][d] * cell.atilde.Atilde[a][b];
+									A2 += cell.geom.tildgamma_inv(a, c) * cell.geom.tildgamma_inv(b, d) 
+										* storage.fields[F_AT(c, d)][n] * storage.fields[F_AT(a, b)][n];
 								}
 							}
 						}
@@ -49,11 +51,12 @@ void Grid::solve_lichnerowicz(int max_iter, float tol, float dx, float dy, float
     }
 
     #pragma omp parallel for collapse(3)
-    for (int i = 0; i < NX; ++i) {
-        for (int j = 0; j < NY; ++j) {
-            for (int k = 0; k < NZ; ++k) {
-                globalGrid[i][j][k].chi = 1.0 / std::pow(std::fmax(psi[i][j][k], 1e-8), 4);
+    for (int i = 0; i < nx; ++i) {
+        for (int j = 0; j < ny; ++j) {
+            for (int k = 0; k < nz; ++k) {
+                at(F_CHI, i, j, k) = 1.0 / std::pow(std::fmax(psi[i][j][k], 1e-8), 4);
             }
         }
     }
+    MemoryBudget::untrack(MEM_ELLIPTIC, nested_vector_bytes(nx, ny, nz));
 }
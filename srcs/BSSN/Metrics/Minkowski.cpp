@@ -7,24 +7,24 @@ void Grid::initializeData_Minkowski()
     float x_min = -128.0, x_max = 128.0;
     float y_min = -128.0, y_max = 128.0;
     float z_min = -128.0, z_max = 128.0;
-    float dx = (x_max - x_min)/(NX-1);
-    float dy = (y_max - y_min)/(NY-1);
-    float dz = (z_max - z_min)/(NZ-1);
+    float dx = (x_max - x_min)/(nx-1);
+    float dy = (y_max - y_min)/(ny-1);
+    float dz = (z_max - z_min)/(nz-1);
 
-    for(int i=0; i<NX; i++)
+    for(int i=0; i<nx; i++)
     {
         float x = x_min + i*dx;
-        for(int j=0; j<NY; j++)
+        for(int j=0; j<ny; j++)
         {
             float y = y_min + j*dy;
-            for(int k=0; k<NZ; k++)
+            for(int k=0; k<nz; k++)
             {
-                Cell2D &cell = globalGrid[i][j][k];
+                Cell2D &cell = getCell(i, j, k);
 
-                cell.gauge.alpha = 1.0;
-                cell.gauge.beta[0] = 0.0;
-                cell.gauge.beta[1] = 0.0;
-                cell.gauge.beta[2] = 0.0;
+                at(F_ALPHA, i, j, k) = 1.0;
+                at(F_BETA0, i, j, k) = 0.0;
+                at(F_BETA1, i, j, k) = 0.0;
+                at(F_BETA2, i, j, k) = 0.0;
 
                 for(int a=0; a<3; a++)
                 {
@@ -36,7 +36,7 @@ void Grid::initializeData_Minkowski()
 
                 for(int a=0; a<3; a++){
                     for(int b=0; b<3; b++){
-                        cell.curv.K[a][b] = 0.0;
+                        at(F_K(a, b), i, j, k) = 0.0;
                     }
                 }
             }
@@ -50,8 +50,8 @@ void Grid::initializeData_Minkowski()
         {
             for(int test_k=0; test_k<3; test_k++)
             {
-                Cell2D &cell = globalGrid[test_i][test_j][test_k];
-                printf("Point (%d,%d,%d): alpha=%f, geom.gamma=\n", test_i, test_j, test_k, cell.gauge.alpha);
+                Cell2D &cell = getCell(test_i, test_j, test_k);
+                printf("Point (%d,%d,%d): alpha=%f, geom.gamma=\n", test_i, test_j, test_k, at(F_ALPHA, test_i, test_j, test_k));
                 for(int a=0; a<3; a++)
                 {
                     printf("  ");
@@ -1,31 +1,306 @@
 #include <Geodesics.h>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <omp.h>
+#if GRID_NUMA
+# include <numa.h>
+# include <numaif.h>
+# include <sched.h>
+#endif
 
 void Grid::allocateGlobalGrid() {
     printf("Allocating optimized grid\n");
 
-    globalGrid.resize(NX);
-    #pragma omp parallel for
-    for (int i = 0; i < NX; i++) {
-        globalGrid[i].resize(NY);
-        for (int j = 0; j < NY; j++) {
-            globalGrid[i][j].assign(NZ, Cell2D());
+    storage.allocate(nx, ny, nz, GHOST, GRID_HUGEPAGES);
+
+    printf("Cell2D: %zu bytes, evolved fields: %zu bytes (%d components), %zu bytes/cell total\n",
+           sizeof(Cell2D), NUM_FIELDS * sizeof(float), (int)NUM_FIELDS,
+           sizeof(Cell2D) + NUM_FIELDS * sizeof(float));
+    printf("Grid block: %.2f MB%s, %d ghost layers (%dx%dx%d padded)\n",
+           storage.bytes / (1024.0 * 1024.0),
+           storage.hugePages ? " (transparent huge pages)" : "",
+           storage.ghost, storage.px, storage.py, storage.pz);
+    if (GRID_BRICK)
+        printf("Layout: %d^3 bricks, %dx%dx%d of them\n", GRID_BRICK,
+               storage.px / std::max(GRID_BRICK, 1), storage.py / std::max(GRID_BRICK, 1),
+               storage.pz / std::max(GRID_BRICK, 1));
+    else
+        printf("Layout: linear, k fastest\n");
+
+    static const char *bind_names[] = { "false", "true", "master", "close", "spread" };
+    const int bind = omp_get_proc_bind();
+    printf("OpenMP: %d threads, proc_bind %s\n", omp_get_max_threads(),
+           (bind >= 0 && bind <= 4) ? bind_names[bind] : "?");
+    if (bind == omp_proc_bind_false && omp_get_max_threads() > 1)
+        printf("  threads are not pinned and may leave the node holding their slab;"
+               " run with OMP_PROC_BIND=spread OMP_PLACES=cores\n");
+    report_page_placement("grid block", storage.block, storage.bytes);
+}
+
+static inline size_t align_up(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+#if GRID_NUMA
+/* MPOL_BIND [p, p + len) to the node of the CPU the calling thread runs on */
+static void bind_to_local_node(char *p, size_t len) {
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t lo = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+    const uintptr_t hi = (reinterpret_cast<uintptr_t>(p) + len + page - 1) & ~(page - 1);
+    const int node = numa_node_of_cpu(sched_getcpu());
+    if (node < 0 || node >= static_cast<int>(8 * sizeof(unsigned long)))
+        return;
+    unsigned long mask = 1UL << node;
+    mbind(reinterpret_cast<void*>(lo), hi - lo, MPOL_BIND, &mask, 8 * sizeof(mask), MPOL_MF_MOVE);
+}
+#endif
+
+/*
+ * Zero count equally sized sub-arrays of len bytes, stride apart, from one
+ * parallel region. Each thread takes the same static fraction of every
+ * sub-array, in granule-sized pieces: on the padded layout that fraction
+ * is an i-slab, which is what the collapse(3) static loops of the
+ * evolution and the static bulk RK helpers later stream from that thread,
+ * so first touch leaves every slab on the node of the thread using it.
+ * With GRID_NUMA the slab is also explicitly bound to that node.
+ */
+static void first_touch(char *base, size_t len, int count, size_t stride, size_t granule) {
+    const size_t npieces = (len + granule - 1) / granule;
+    #pragma omp parallel
+    {
+        const size_t nth = omp_get_num_threads(), tid = omp_get_thread_num();
+        const size_t lo = std::min(len, npieces * tid / nth * granule);
+        const size_t hi = std::min(len, npieces * (tid + 1) / nth * granule);
+        for (int a = 0; a < count && hi > lo; a++) {
+            char *p = base + a * stride + lo;
+#if GRID_NUMA
+            if (numa_available() >= 0)
+                bind_to_local_node(p, hi - lo);
+#endif
+            memset(p, 0, hi - lo);
         }
     }
+}
 
-    const size_t total_cells = NX * NY * NZ;
-    for (int a = 0; a < 3; a++) {
-        for (int b = 0; b < 3; b++) {
-            dgammaX[a][b].clear();
-            dgammaX[a][b].reserve(total_cells);  
-            dgammaX[a][b].resize(total_cells, 0.0);
-
-            dgammaY[a][b].clear();
-            dgammaY[a][b].resize(total_cells, 0.0);
-            
-            dgammaZ[a][b].clear();
-            dgammaZ[a][b].resize(total_cells, 0.0);
-        }
+/*
+ * Sample the pages of [block, block + bytes) and print which NUMA node
+ * backs them. move_pages() with a null node list only queries; where the
+ * kernel does not support it the report says so and nothing else happens.
+ */
+void report_page_placement(const char *what, const void *block, size_t bytes) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t npages = (bytes + page - 1) / page;
+    const size_t nsample = std::min<size_t>(npages, 1024);
+    if (!block || nsample == 0)
+        return;
+
+    std::vector<void*> pages(nsample);
+    std::vector<int> status(nsample, -1);
+    for (size_t s = 0; s < nsample; s++)
+        pages[s] = const_cast<char*>(static_cast<const char*>(block)) + (s * npages / nsample) * page;
+    if (syscall(SYS_move_pages, 0, nsample, pages.data(), nullptr, status.data(), 0) != 0) {
+        printf("NUMA placement of %s: unavailable\n", what);
+        return;
+    }
+
+    const int max_nodes = 64;
+    size_t count[max_nodes] = {};
+    size_t unknown = 0;
+    for (size_t s = 0; s < nsample; s++) {
+        if (status[s] >= 0 && status[s] < max_nodes)
+            count[status[s]]++;
+        else
+            unknown++;
     }
+    printf("NUMA placement of %s (%zu pages sampled):", what, nsample);
+    for (int n = 0; n < max_nodes; n++)
+        if (count[n])
+            printf(" node%d %.1f%%", n, 100.0 * count[n] / nsample);
+    if (unknown)
+        printf(" unresolved %.1f%%", 100.0 * unknown / nsample);
+    printf("\n");
+}
+
+/*
+ * One aligned, untouched block; with huge pages it is 2 MB aligned and
+ * madvise'd so the kernel can back it with THP, which keeps the TLB
+ * footprint of the stencils small. The owner first touches it through
+ * first_touch() once it knows its sub-array layout.
+ */
+static inline size_t block_alignment(bool useHugePages) {
+    return useHugePages ? HUGE_PAGE_SIZE : FIELD_ALIGNMENT;
+}
+
+static void *allocate_block(size_t &bytes, bool useHugePages, bool &hugePages,
+                            MemSubsystem sub, const char *what) {
+    const size_t alignment = block_alignment(useHugePages);
+    bytes = align_up(bytes, alignment);
+
+    void *block = std::aligned_alloc(alignment, bytes);
+    if (!block) {
+        fprintf(stderr, "Failed to allocate grid storage (%zu bytes)\n", bytes);
+        exit(1);
+    }
+    hugePages = false;
+#ifdef MADV_HUGEPAGE
+    if (useHugePages)
+        hugePages = madvise(block, bytes, MADV_HUGEPAGE) == 0;
+#endif
+    MemoryBudget::track(sub, what, bytes);
+    return block;
+}
+
+static inline size_t touch_granule(bool hugePages) {
+    return hugePages ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/*
+ * Carve the cell array and the NUM_FIELDS evolved components out of one
+ * block. Every sub-array starts on a FIELD_ALIGNMENT boundary.
+ */
+void Grid::GridStorage::allocate(int nx_, int ny_, int nz_, int ghost_, bool useHugePages) {
+    release();
+    nx = nx_;
+    ny = ny_;
+    nz = nz_;
+    ghost = ghost_;
+    px = padded_extent(nx, ghost);
+    py = padded_extent(ny, ghost);
+    pz = padded_extent(nz, ghost);
+
+    const size_t n = size();
+    const size_t cell_bytes = align_up(n * sizeof(Cell2D), FIELD_ALIGNMENT);
+    const size_t field_bytes = align_up(n * sizeof(float), FIELD_ALIGNMENT);
+    bytes = cell_bytes + NUM_FIELDS * field_bytes;
+    block = allocate_block(bytes, useHugePages, hugePages, MEM_GRID, "grid block");
+
+    char *base = static_cast<char*>(block);
+    first_touch(base, cell_bytes, 1, 0, touch_granule(hugePages));
+    first_touch(base + cell_bytes, field_bytes, NUM_FIELDS, field_bytes, touch_granule(hugePages));
+    cells = reinterpret_cast<Cell2D*>(base);
+    for (int f = 0; f < NUM_FIELDS; f++)
+        fields[f] = reinterpret_cast<float*>(base + cell_bytes + f * field_bytes);
+}
+
+size_t Grid::GridStorage::bytes_for(int nx_, int ny_, int nz_, int ghost_, bool useHugePages) {
+    const size_t n = static_cast<size_t>(padded_extent(nx_, ghost_)) * padded_extent(ny_, ghost_)
+                   * padded_extent(nz_, ghost_);
+    const size_t bytes_ = align_up(n * sizeof(Cell2D), FIELD_ALIGNMENT)
+                        + NUM_FIELDS * align_up(n * sizeof(float), FIELD_ALIGNMENT);
+    return align_up(bytes_, block_alignment(useHugePages));
+}
+
+void Grid::GridStorage::release() {
+    if (block)
+        MemoryBudget::untrack(MEM_GRID, bytes);
+    std::free(block);
+    block = nullptr;
+    cells = nullptr;
+    for (int f = 0; f < NUM_FIELDS; f++)
+        fields[f] = nullptr;
+    bytes = 0;
+    nx = ny = nz = 0;
+    px = py = pz = 0;
+    ghost = 0;
+}
+
+void Grid::StageRegisters::allocate(size_t npts_, int nregs_, bool useHugePages) {
+    release();
+    npts = npts_;
+    nregs = std::min(nregs_, RK_MAX_REGS);
+
+    const size_t field_bytes = align_up(npts * sizeof(float), FIELD_ALIGNMENT);
+    bytes = static_cast<size_t>(nregs) * NUM_FIELDS * field_bytes;
+    block = allocate_block(bytes, useHugePages, hugePages, MEM_RK, "RK registers");
+
+    char *base = static_cast<char*>(block);
+    first_touch(base, field_bytes, nregs * NUM_FIELDS, field_bytes, touch_granule(hugePages));
+    for (int r = 0; r < nregs; r++)
+        for (int f = 0; f < NUM_FIELDS; f++)
+            reg[r][f] = reinterpret_cast<float*>(base + (static_cast<size_t>(r) * NUM_FIELDS + f) * field_bytes);
+}
+
+size_t Grid::StageRegisters::bytes_for(size_t npts_, int nregs_, bool useHugePages) {
+    const size_t bytes_ = static_cast<size_t>(std::min(nregs_, RK_MAX_REGS)) * NUM_FIELDS
+                        * align_up(npts_ * sizeof(float), FIELD_ALIGNMENT);
+    return align_up(bytes_, block_alignment(useHugePages));
+}
+
+void Grid::StageRegisters::release() {
+    if (block)
+        MemoryBudget::untrack(MEM_RK, bytes);
+    std::free(block);
+    block = nullptr;
+    for (int r = 0; r < RK_MAX_REGS; r++)
+        for (int f = 0; f < NUM_FIELDS; f++)
+            reg[r][f] = nullptr;
+    nregs = 0;
+    npts = 0;
+    bytes = 0;
+}
+
+void Grid::DerivativeCache::allocate(size_t npts_, bool useHugePages) {
+    release();
+    npts = npts_;
+
+    const size_t field_bytes = align_up(npts * sizeof(float), FIELD_ALIGNMENT);
+    bytes = NARRAYS * field_bytes;
+    block = allocate_block(bytes, useHugePages, hugePages, MEM_DERIV_CACHE, "derivative cache");
+
+    char *base = static_cast<char*>(block);
+    first_touch(base, field_bytes, NARRAYS, field_bytes, touch_granule(hugePages));
+    for (int m = 0; m < 3; m++)
+        for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+            d[m][f] = reinterpret_cast<float*>(base + (static_cast<size_t>(m) * NUM_DERIV_FIELDS + f) * field_bytes);
+    base += 3 * NUM_DERIV_FIELDS * field_bytes;
+    for (int h = 0; h < NUM_HESS_FIELDS; h++)
+        for (int c = 0; c < SYM_NCOMP; c++)
+            dd[h][c] = reinterpret_cast<float*>(base + (static_cast<size_t>(h) * SYM_NCOMP + c) * field_bytes);
+    base += NUM_HESS_FIELDS * SYM_NCOMP * field_bytes;
+    for (int a = 0; a < NUM_ADV_FIELDS; a++)
+        adv[a] = reinterpret_cast<float*>(base + static_cast<size_t>(a) * field_bytes);
+}
+
+size_t Grid::DerivativeCache::bytes_for(size_t npts_, bool useHugePages) {
+    const size_t bytes_ = NARRAYS * align_up(npts_ * sizeof(float), FIELD_ALIGNMENT);
+    return align_up(bytes_, block_alignment(useHugePages));
+}
+
+void Grid::DerivativeCache::release() {
+    if (block)
+        MemoryBudget::untrack(MEM_DERIV_CACHE, bytes);
+    std::free(block);
+    block = nullptr;
+    for (int m = 0; m < 3; m++)
+        for (int f = 0; f < NUM_DERIV_FIELDS; f++)
+            d[m][f] = nullptr;
+    for (int h = 0; h < NUM_HESS_FIELDS; h++)
+        for (int c = 0; c < SYM_NCOMP; c++)
+            dd[h][c] = nullptr;
+    for (int a = 0; a < NUM_ADV_FIELDS; a++)
+        adv[a] = nullptr;
+    npts = 0;
+    bytes = 0;
+    valid = false;
+}
+
+Grid::~Grid() {
+    dcache.release();
+    rk.release();
+    storage.release();
+}
+
+/*
+ * Copy every stored quantity of point (is, js, ks) into (id, jd, kd),
+ * cell data and evolved fields alike.
+ */
+void Grid::copyPoint(int id, int jd, int kd, int is, int js, int ks) {
+    const size_t dst = idx(id, jd, kd), src = idx(is, js, ks);
+    storage.cells[dst] = storage.cells[src];
+    for (int f = 0; f < NUM_FIELDS; f++)
+        storage.fields[f][dst] = storage.fields[f][src];
 }
 
 
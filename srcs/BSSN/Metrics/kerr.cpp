@@ -25,19 +25,20 @@ void Grid::initializeKerrData(Grid &grid_obj) {
     float y_min = -L, y_max = L;
     float z_min = -L, z_max = L;
 
-    float dx = (x_max - x_min) / (NX - 1);
-    float dy = (y_max - y_min) / (NY - 1);
-    float dz = (z_max - z_min) / (NZ - 1);
+    float dx = (x_max - x_min) / (nx - 1);
+    float dy = (y_max - y_min) / (ny - 1);
+    float dz = (z_max - z_min) / (nz - 1);
 
     GridTensor gridtensor;
     Matrix matrix;
 
-    globalGrid.resize(NX, std::vector<std::vector<Cell2D>>(NY, std::vector<Cell2D>(NZ)));
+    if (!storage.cells)
+        allocateGlobalGrid();
 
     #pragma omp parallel for collapse(3) schedule(dynamic)
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
+    for (int i = 0; i < nx; i++) {
+        for (int j = 0; j < ny; j++) {
+            for (int k = 0; k < nz; k++) {
                 float x = x_min + i * dx;
                 float y = y_min + j * dy;
                 float z = z_min + k * dz;
@@ -63,7 +64,7 @@ void Grid::initializeKerrData(Grid &grid_obj) {
                     lz /= norm_l;
                 }
 
-                Cell2D &cell = globalGrid[i][j][k];
+                Cell2D &cell = getCell(i, j, k);
 
                 cell.geom.gamma[0][0] = 1.0 + 2.0 * H * lx * lx;
                 cell.geom.gamma[0][1] = 2.0 * H * lx * ly;
@@ -83,37 +84,38 @@ void Grid::initializeKerrData(Grid &grid_obj) {
                   - cell.geom.gamma[1][1] * cell.geom.gamma[0][2] * cell.geom.gamma[2][0]
                   - cell.geom.gamma[2][2] * cell.geom.gamma[0][1] * cell.geom.gamma[1][0]
                 );
-                cell.chi = 1.0 / det_gamma;
+                at(F_CHI, i, j, k) = 1.0 / det_gamma;
 
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        cell.geom.tilde_gamma[a][b] = cell.chi * cell.geom.gamma[a][b];
+                        at(F_GT(a, b), i, j, k) = at(F_CHI, i, j, k) * cell.geom.gamma[a][b];
 
                 Matrix3x3 tilde_gamma_std;
                 Matrix3x3 tilde_gamma_inv_std;
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        tilde_gamma_std[a][b] = cell.geom.tilde_gamma[a][b];
+                        tilde_gamma_std[a][b] = at(F_GT(a, b), i, j, k);
                 matrix.inverse_3x3(tilde_gamma_std, tilde_gamma_inv_std);
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        cell.geom.tildgamma_inv[a][b] = tilde_gamma_inv_std[a][b];
+                        cell.geom.tildgamma_inv(a, b) = tilde_gamma_inv_std[a][b];
 
-                cell.gauge.alpha = 1.0 / std::sqrt(1.0 + 2.0 * H);
-                cell.gauge.beta[0] = 2.0 * H * lx;
-                cell.gauge.beta[1] = 2.0 * H * ly;
-                cell.gauge.beta[2] = 2.0 * H * lz;
+                at(F_ALPHA, i, j, k) = 1.0 / std::sqrt(1.0 + 2.0 * H);
+                at(F_BETA0, i, j, k) = 2.0 * H * lx;
+                at(F_BETA1, i, j, k) = 2.0 * H * ly;
+                at(F_BETA2, i, j, k) = 2.0 * H * lz;
 
                 for (int a = 0; a < 3; a++)
                     for (int b = 0; b < 3; b++)
-                        cell.curv.K[a][b] = 0.0;
+                        at(F_K(a, b), i, j, k) = 0.0;
             }
         }
     }
+    fill_ghosts();
 
-    for (int i = 1; i < NX - 1; i++) {
-        for (int j = 1; j < NY - 1; j++) {
-            for (int k = 1; k < NZ - 1; k++) {
+    for (int i = 1; i < nx - 1; i++) {
+        for (int j = 1; j < ny - 1; j++) {
+            for (int k = 1; k < nz - 1; k++) {
                 gridtensor.compute_extrinsic_curvature(*this, i, j, k, dx, dy, dz);
                 gridtensor.compute_Atilde(*this, i, j, k);
             }
@@ -126,7 +128,7 @@ void Grid::initializeKerrData(Grid &grid_obj) {
     for (int p = 0; p < 3; p++) {
         printf("  ");
         for (int q = 0; q < 3; q++) {
-            printf("%e ", globalGrid[1][1][1].curv.K[p][q]);
+            printf("%e ", at(F_K(p, q), 1, 1, 1));
         }
         printf("\n");
     }
@@ -134,12 +136,12 @@ void Grid::initializeKerrData(Grid &grid_obj) {
     for (int p = 0; p < 3; p++) {
         printf("  ");
         for (int q = 0; q < 3; q++) {
-            printf("%e ", globalGrid[1][1][1].geom.gamma[p][q]);
+            printf("%e ", getCell(1, 1, 1).geom.gamma[p][q]);
         }
         printf("\n");
     }
-    printf("chi near (1,1,1) = %e\n", globalGrid[1][1][1].chi);
-    printf("alpha_1_1_1 = %e\n", globalGrid[1][1][1].gauge.alpha);
+    printf("chi near (1,1,1) = %e\n", at(F_CHI, 1, 1, 1));
+    printf("alpha_1_1_1 = %e\n", at(F_ALPHA, 1, 1, 1));
     
     float test_radii[] = {0.5, 1.0, 2.0, 5.0, 10.0};
     for (float test_r : test_radii) {
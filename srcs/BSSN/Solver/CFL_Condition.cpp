@@ -1,38 +1,96 @@
 #include <Geodesics.h>
 #include <algorithm>
 
-/**
- * Compute the maximum speed in the grid
- * @return the maximum speed in the grid
- * need to be improved
+/*
+ * Per-axis maximum characteristic speed over the interior, see
+ * characteristic_speed(), as a parallel SIMD max-reduction. Only needed
+ * when no stage sweep has reduced it yet (first step, fresh data); must
+ * be called outside a parallel region.
  */
-
-float Grid::computeMaxSpeed() {
-    float maxSpeed = 0.0;
-    for (int i = 1; i < NX - 1; i++) {
-        for (int j = 1; j < NY - 1; j++) {
-            for (int k = 1; k < NZ - 1; k++) {
-                Cell2D &cell = globalGrid[i][j][k];
-                float betaNorm = std::sqrt(cell.gauge.beta[0]*cell.gauge.beta[0] +
-                                            cell.gauge.beta[1]*cell.gauge.beta[1] +
-                                            cell.gauge.beta[2]*cell.gauge.beta[2]);
-                float localSpeed = std::fabs(cell.gauge.alpha) + betaNorm;
-                if (localSpeed > maxSpeed) {
-                    maxSpeed = localSpeed;
-                }
+void Grid::computeMaxSpeed(float speed[3]) {
+    float vx = 0.0f, vy = 0.0f, vz = 0.0f;
+    #pragma omp parallel for collapse(2) reduction(max: vx, vy, vz) schedule(static)
+    for (int i = 1; i < nx - 1; i++) {
+        for (int j = 1; j < ny - 1; j++) {
+            #pragma omp simd reduction(max: vx, vy, vz)
+            for (int k = 1; k < nz - 1; k++) {
+                const size_t n = idx(i, j, k);
+                const float beta[3] = { storage.fields[F_BETA0][n], storage.fields[F_BETA1][n],
+                                        storage.fields[F_BETA2][n] };
+                float gt[SYM_NCOMP], v[3];
+                for (int c = 0; c < SYM_NCOMP; c++)
+                    gt[c] = storage.fields[F_GTXX + c][n];
+                characteristic_speed(storage.fields[F_ALPHA][n], beta, storage.fields[F_CHI][n], gt, v);
+                vx = std::max(vx, v[0]);
+                vy = std::max(vy, v[1]);
+                vz = std::max(vz, v[2]);
             }
         }
     }
-    return maxSpeed;
+    speed[0] = vx;
+    speed[1] = vy;
+    speed[2] = vz;
 }
 
+/*
+ * CFL * min_m h_m / v_m from the per-axis speeds the last stage sweep
+ * reduced, or from a fresh computeMaxSpeed() when there are none.
+ */
 float Grid::computeCFL_dt(float CFL) {
-    float dx_min = std::min({DX, DY, DZ});
-    float maxSpeed = computeMaxSpeed();
-    
-    if (maxSpeed < 1e-10) {
+    if (!max_speed_valid) {
+        computeMaxSpeed(max_speed);
+        max_speed_valid = true;
+    }
+    const float h[3] = { dx, dy, dz };
+    float dt = 0.0f;
+    for (int m = 0; m < 3; m++)
+        if (max_speed[m] >= 1e-10f)
+            dt = dt > 0.0f ? std::min(dt, h[m] / max_speed[m]) : h[m] / max_speed[m];
+
+    if (dt <= 0.0f) {
         return 1e-10;
     }
-    
-    return CFL * dx_min / maxSpeed;
+
+    return CFL * dt;
+}
+
+StepControl step_control() {
+    StepControl ctl;
+    const char *rtol = getenv("GRID_RK_RTOL");
+    const char *atol = getenv("GRID_RK_ATOL");
+    if (rtol)
+        ctl.rtol = static_cast<float>(atof(rtol));
+    if (atol)
+        ctl.atol = static_cast<float>(atof(atol));
+    return ctl;
+}
+
+/*
+ * PI control for an error estimate of order 3 (Hairer and Wanner,
+ * Solving ODEs II, IV.2): after an accepted step
+ * dt *= 0.9 err^(-0.7/3) err_prev^(0.4/3), after a rejection
+ * dt *= 0.9 err^(-1/3) with no growth allowed. Either way the change is
+ * kept within [0.2, 5] and an accepted dt within dt_max; a rejection only
+ * ever shrinks dt. A NaN or Inf error is a rejection at the largest cut.
+ */
+bool StepControl::update(float err, float &dt, float dt_max) {
+    const float k = 3.0f, safety = 0.9f, fac_min = 0.2f, fac_max = 5.0f;
+    if (!std::isfinite(err)) {
+        dt *= fac_min;
+        rejected++;
+        return false;
+    }
+    const float e = std::max(err, 1e-10f);
+
+    if (e <= 1.0f) {
+        const float fac = safety * std::pow(e, -0.7f / k) * std::pow(err_prev, 0.4f / k);
+        dt = std::min(dt_max, dt * std::clamp(fac, fac_min, fac_max));
+        err_prev = std::max(e, 1e-4f);
+        accepted++;
+        return true;
+    }
+    const float fac = safety * std::pow(e, -1.0f / k);
+    dt *= std::clamp(fac, fac_min, 1.0f);
+    rejected++;
+    return false;
 }
@@ -0,0 +1,180 @@
+#include <Geodesics.h>
+
+/*
+ * The integrators of the method-of-lines driver. Every stage update is a
+ * mol_lincomb() over whole registries, so a scheme is its tableau written
+ * as a short list of linear combinations and nothing else; the RHS and
+ * its boundary treatment stay behind MolRHS.
+ */
+
+void mol_fill(const MolState &out, float value) {
+    for (int v = 0; v < out.nvar; v++) {
+        float *o = out.var[v];
+        #pragma omp for simd schedule(static) nowait
+        for (size_t n = 0; n < out.npts; n++)
+            o[n] = value;
+    }
+    #pragma omp barrier
+}
+
+void MolRHS::stiff_rhs(const MolState &y, const MolState &k) {
+    (void)y;
+    mol_fill(k, 0.0f);
+}
+
+void MolRHS::stiff_solve(float gdt, const MolState &y) {
+    (void)gdt;
+    (void)y;
+}
+
+/*
+ * Classic RK4 in three registries: the step-start state, the weighted RHS
+ * accumulator and the stage RHS. Stage s + 1 starts from y0 + c_s dt k_s,
+ * the step ends at y0 + dt/6 (k_0 + 2 k_1 + 2 k_2 + k_3).
+ */
+class MolRK4 : public MolIntegrator {
+    public:
+        const char *name() const override { return "classic RK4"; }
+        int nregs() const override { return 3; }
+        int stages() const override { return 4; }
+        int traffic() const override { return 2 + 5 + 2 * 6 + 4; }
+
+        void step(MolRHS &f, const MolState &y, const MolState *reg, float dt) const override {
+            static const float c[3] = {0.5f, 0.5f, 1.0f};
+            const MolState &y0 = reg[0], &acc = reg[1], &k = reg[2];
+            mol_lincomb(y0, {1.0f}, {&y});
+            for (int s = 0; s < 3; s++) {
+                f.rhs(y, k, false);
+                if (s == 0)
+                    mol_lincomb(acc, {1.0f}, {&k});
+                else
+                    mol_lincomb(acc, {1.0f, 2.0f}, {&acc, &k});
+                mol_lincomb(y, {1.0f, c[s] * dt}, {&y0, &k});
+            }
+            f.rhs(y, k, true);
+            mol_lincomb(y, {1.0f, dt / 6.0f, dt / 6.0f}, {&y0, &acc, &k});
+        }
+};
+
+/*
+ * Three-stage third-order strong-stability-preserving RK in the Shu-Osher
+ * form (Shu and Osher, J. Comput. Phys. 77, 1988): every stage is a convex
+ * combination of forward Euler steps, so it keeps any bound forward Euler
+ * keeps at the same CFL.
+ */
+class MolSSPRK3 : public MolIntegrator {
+    public:
+        const char *name() const override { return "SSP-RK3"; }
+        int nregs() const override { return 2; }
+        int stages() const override { return 3; }
+        int traffic() const override { return 2 + 3 + 4 + 4; }
+
+        void step(MolRHS &f, const MolState &y, const MolState *reg, float dt) const override {
+            const MolState &y0 = reg[0], &k = reg[1];
+            mol_lincomb(y0, {1.0f}, {&y});
+            f.rhs(y, k, false);
+            mol_lincomb(y, {1.0f, dt}, {&y, &k});
+            f.rhs(y, k, false);
+            mol_lincomb(y, {0.75f, 0.25f, 0.25f * dt}, {&y0, &y, &k});
+            f.rhs(y, k, true);
+            mol_lincomb(y, {1.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f * dt}, {&y0, &y, &k});
+        }
+};
+
+/*
+ * Five-stage fourth-order 2N-storage RK of Carpenter and Kennedy (NASA
+ * TM-109112, 1994): dq = A[s] dq + dt k, y += B[s] dq. The RHS lands in
+ * a registry of its own, so this takes two where the fused GRID_LSRK
+ * path folds it into dq on the spot.
+ */
+class MolLSRK : public MolIntegrator {
+    public:
+        const char *name() const override { return "2N-storage RK4(5)"; }
+        int nregs() const override { return 2; }
+        int stages() const override { return 5; }
+        int traffic() const override { return 5 + 4 * 6; }
+
+        void step(MolRHS &f, const MolState &y, const MolState *reg, float dt) const override {
+            static const float A[5] = {
+                0.0f,
+                -567301805773.0f / 1357537059087.0f,
+                -2404267990393.0f / 2016746695238.0f,
+                -3550918686646.0f / 2091501179385.0f,
+                -1275806237668.0f / 842570457699.0f
+            };
+            static const float B[5] = {
+                1432997174477.0f / 9575080441755.0f,
+                5161836677717.0f / 13612068292357.0f,
+                1720146321549.0f / 2090206949498.0f,
+                3134564353537.0f / 4481467310338.0f,
+                2277821191437.0f / 14882151754819.0f
+            };
+            const MolState &dq = reg[0], &k = reg[1];
+            for (int s = 0; s < 5; s++) {
+                f.rhs(y, k, s == 4);
+                if (s == 0)
+                    mol_lincomb(dq, {dt}, {&k});
+                else
+                    mol_lincomb(dq, {A[s], dt}, {&dq, &k});
+                mol_lincomb(y, {1.0f, B[s]}, {&y, &dq});
+            }
+        }
+};
+
+/*
+ * IMEX-SSP2(2,2,2) of Pareschi and Russo (J. Sci. Comput. 25, 2005): the
+ * non-stiff part goes through the explicit SSP-RK2 tableau, the stiff
+ * part through the L-stable SDIRK one with gamma = 1 - 1/sqrt(2),
+ *
+ *   Y1 = y0 + gamma dt g(Y1)
+ *   Y2 = y0 + dt f(Y1) + (1 - 2 gamma) dt g(Y1) + gamma dt g(Y2)
+ *   y1 = y0 + dt/2 (f(Y1) + g(Y1) + f(Y2) + g(Y2))
+ *
+ * with each implicit stage handed to MolRHS::stiff_solve(). Registries:
+ * y0, f, g and the stage-1 sum f + g.
+ */
+class MolIMEX : public MolIntegrator {
+    public:
+        const char *name() const override { return "IMEX-SSP2(2,2,2)"; }
+        int nregs() const override { return 4; }
+        int stages() const override { return 2; }
+        int traffic() const override { return 2 + 3 + 4 + 5; }
+        bool imex() const override { return true; }
+
+        void step(MolRHS &f, const MolState &y, const MolState *reg, float dt) const override {
+            const float gamma = 1.0f - 1.0f / std::sqrt(2.0f);
+            const MolState &y0 = reg[0], &kf = reg[1], &kg = reg[2], &acc = reg[3];
+            mol_lincomb(y0, {1.0f}, {&y});
+            f.stiff_solve(gamma * dt, y);
+            f.rhs(y, kf, false);
+            f.stiff_rhs(y, kg);
+            mol_lincomb(acc, {1.0f, 1.0f}, {&kf, &kg});
+            mol_lincomb(y, {1.0f, dt, (1.0f - 2.0f * gamma) * dt}, {&y0, &kf, &kg});
+            f.stiff_solve(gamma * dt, y);
+            f.rhs(y, kf, true);
+            f.stiff_rhs(y, kg);
+            const float h = 0.5f * dt;
+            mol_lincomb(y, {1.0f, h, h, h}, {&y0, &acc, &kf, &kg});
+        }
+};
+
+const MolIntegrator *mol_integrator(const char *name) {
+    static const MolRK4 rk4;
+    static const MolSSPRK3 ssprk3;
+    static const MolLSRK lsrk;
+    static const MolIMEX imex;
+    if (!strcmp(name, "rk4"))
+        return &rk4;
+    if (!strcmp(name, "ssprk3"))
+        return &ssprk3;
+    if (!strcmp(name, "lsrk"))
+        return &lsrk;
+    if (!strcmp(name, "imex"))
+        return &imex;
+    return NULL;
+}
+
+const MolIntegrator *mol_scheme() {
+    const char *env = getenv("GRID_MOL_SCHEME");
+    return mol_integrator(env ? env : MOL_SCHEME);
+}
@@ -0,0 +1,262 @@
+#include <Geodesics.h>
+
+/*
+ * The BSSN system as seen by the method-of-lines integrators: every field
+ * with a right-hand side, in Field order. Atilde is left out, the RHS
+ * rebuilds it from K; chi is in, driven by the dt_chi that
+ * compute_time_derivatives() leaves in the cell.
+ */
+static const Field MOL_FIELDS[] = {
+    F_ALPHA, F_BETA0, F_BETA1, F_BETA2, F_CHI,
+    F_GTXX, F_GTXY, F_GTXZ, F_GTYY, F_GTYZ, F_GTZZ,
+    F_KXX, F_KXY, F_KXZ, F_KYY, F_KYZ, F_KZZ
+};
+static const char *MOL_NAMES[] = {
+    "alpha", "beta0", "beta1", "beta2", "chi",
+    "gt_xx", "gt_xy", "gt_xz", "gt_yy", "gt_yz", "gt_zz",
+    "K_xx",  "K_xy",  "K_xz",  "K_yy",  "K_yz",  "K_zz"
+};
+static constexpr int MOL_NVARS = sizeof(MOL_FIELDS) / sizeof(MOL_FIELDS[0]);
+static_assert(MOL_NVARS <= MOL_MAX_VARS, "MOL_FIELDS overflows a MolState");
+static_assert(MOL_MAX_REGS <= RK_MAX_REGS, "MolState registries live in StageRegisters");
+
+/* beta^m sits right after alpha in MOL_FIELDS */
+static inline int mol_beta(int m) {
+    return 1 + m;
+}
+
+/*
+ * y over GridStorage::fields, reg[r] over register r of StageRegisters,
+ * for r < nregs. The pointers are fixed for the whole run: nothing on the
+ * method-of-lines path rotates them.
+ */
+void Grid::mol_registry(MolState &y, MolState *reg, int nregs) {
+    y = MolState();
+    y.npts = storage.size();
+    for (int v = 0; v < MOL_NVARS; v++)
+        y.add(MOL_NAMES[v], storage.fields[MOL_FIELDS[v]]);
+    for (int r = 0; r < nregs; r++) {
+        reg[r] = MolState();
+        reg[r].npts = storage.size();
+        for (int v = 0; v < MOL_NVARS; v++)
+            reg[r].add(MOL_NAMES[v], rk.reg[r][MOL_FIELDS[v]]);
+    }
+}
+
+/*
+ * k = f(y) of every registered variable at the current state: ghosts and
+ * derivative cache refreshed, then one sweep over the physical points
+ * that runs the point kernels on the interior and writes their RHS plus
+ * the Kreiss-Oliger term to k. Boundary points get k = 0 and so keep their
+ * step-start values under any scheme, as in the fused path; ghosts of k
+ * are never written and stay at their first-touch zero. With
+ * split_damping the -eta beta term of the Gamma driver is left out, it is
+ * the stiff part mol_damping_rhs() supplies. The constraints are
+ * evaluated when last is set. Orphaned worksharing, ends with a barrier.
+ */
+template <typename D>
+void Grid::mol_rhs(const MolState &k, bool last, bool split_damping) {
+    const int nx_ = D::nx(*this), ny_ = D::ny(*this), nz_ = D::nz(*this);
+    const float sigma = ko_sigma;
+
+    fill_ghosts();
+#if GRID_DERIV_CACHE
+    fill_derivative_cache<D>();
+#endif
+    for_each_row(0, nx_, 0, ny_, 0, nz_, [&](int i, int j, int kb, int ke) {
+        const bool face = i == 0 || i == nx_ - 1 || j == 0 || j == ny_ - 1;
+        for (int kk = kb; kk < ke; kk++) {
+            const size_t n = idx(i, j, kk);
+            if (face || kk == 0 || kk == nz_ - 1) {
+                for (int v = 0; v < k.nvar; v++)
+                    k.var[v][n] = 0.0f;
+                continue;
+            }
+            compute_time_derivatives<D>(*this, i, j, kk);
+            float d_alpha_dt, d_beta_dt[3];
+            compute_gauge_derivatives(*this, i, j, kk, d_alpha_dt, d_beta_dt);
+            if (last) {
+                float hamiltonian, momentum[3];
+                compute_constraints(*this, i, j, kk, hamiltonian, momentum);
+            }
+            const Cell2D &cell = getCell(i, j, kk);
+            float r[NUM_FIELDS];
+            r[F_ALPHA] = d_alpha_dt;
+            const float eta = split_damping ? shift_damping(i, j, kk) : 0.0f;
+            for (int m = 0; m < 3; m++)
+                r[F_BETA(m)] = d_beta_dt[m] + eta * storage.fields[F_BETA(m)][n];
+            r[F_CHI] = cell.dt_chi;
+            for (int c = 0; c < SYM_NCOMP; c++) {
+                r[F_GTXX + c] = cell.dgt[c];
+                r[F_KXX + c] = cell.curv.dKt[c];
+            }
+            for (int v = 0; v < k.nvar; v++) {
+                const Field f = MOL_FIELDS[v];
+                const float ko = sigma != 0.0f ? sigma * ko_dissipation<D>(*this, storage.fields[f], i, j, kk) : 0.0f;
+                k.var[v][n] = r[f] + ko;
+            }
+        }
+    });
+    #pragma omp single
+    dcache.valid = false;
+}
+
+#define INSTANTIATE_MOL_RHS(N) \
+	template void Grid::mol_rhs<GridDims<N>>(const MolState &, bool, bool);
+GRID_FAST_SIZES(INSTANTIATE_MOL_RHS)
+INSTANTIATE_MOL_RHS(0)
+
+/*
+ * Stiff part of the split RHS: g = -eta beta for the shift, 0 for
+ * everything else and off the interior. eta comes from the current K
+ * through the inverse metric of the last RHS evaluation.
+ */
+void Grid::mol_damping_rhs(const MolState &k) {
+    mol_fill(k, 0.0f);
+    for_each_row(1, nx - 1, 1, ny - 1, 1, nz - 1, [&](int i, int j, int kb, int ke) {
+        for (int kk = kb; kk < ke; kk++) {
+            const size_t n = idx(i, j, kk);
+            const float eta = shift_damping(i, j, kk);
+            for (int m = 0; m < 3; m++)
+                k.var[mol_beta(m)][n] = -eta * storage.fields[F_BETA(m)][n];
+        }
+    });
+}
+
+/*
+ * Implicit stage of the damping: beta = z - gdt eta beta is linear in
+ * beta at fixed K, so the solve is beta = z / (1 + gdt eta), point by
+ * point on the interior.
+ */
+void Grid::mol_damping_solve(float gdt) {
+    for_each_row(1, nx - 1, 1, ny - 1, 1, nz - 1, [&](int i, int j, int kb, int ke) {
+        for (int kk = kb; kk < ke; kk++) {
+            const size_t n = idx(i, j, kk);
+            const float s = 1.0f / (1.0f + gdt * shift_damping(i, j, kk));
+            for (int m = 0; m < 3; m++)
+                storage.fields[F_BETA(m)][n] *= s;
+        }
+    });
+}
+
+/*
+ * The BSSN right-hand side behind the MolRHS interface. Only an IMEX
+ * scheme gets the shift damping as a separate stiff part; for the others
+ * it stays in f.
+ */
+template <typename D>
+class BSSNSystem : public MolRHS {
+    public:
+        BSSNSystem(Grid &grid_, bool split_) : grid(grid_), split(split_) {}
+
+        void rhs(const MolState &y, const MolState &k, bool last) override {
+            (void)y;
+            grid.mol_rhs<D>(k, last, split);
+        }
+        void stiff_rhs(const MolState &y, const MolState &k) override {
+            if (split)
+                grid.mol_damping_rhs(k);
+            else
+                MolRHS::stiff_rhs(y, k);
+        }
+        void stiff_solve(float gdt, const MolState &y) override {
+            (void)y;
+            if (split)
+                grid.mol_damping_solve(gdt);
+        }
+
+    private:
+        Grid &grid;
+        bool split;
+};
+
+/*
+ * evolve() with GRID_MOL: the evolved variables become a MolState
+ * registry and each step is one MolIntegrator::step() of the scheme
+ * mol_scheme() picks, over the BSSN RHS. The integrator streams its stage
+ * updates through mol_lincomb() between RHS sweeps, so unlike
+ * evolve_steps() nothing is fused into the sweep: the characteristic
+ * speeds for the CFL dt are reduced afresh every step.
+ */
+template <typename D>
+void Grid::evolve_mol(Grid &grid_obj, float dtInitial, int nSteps) {
+    GridTensor gridTensor;
+    float CFL = 0.5;
+    float dt = dtInitial;
+    const int nx_ = D::nx(grid_obj), ny_ = D::ny(grid_obj), nz_ = D::nz(grid_obj);
+    double total_time = 0.0;
+
+    const MolIntegrator *scheme = mol_scheme();
+    if (!scheme) {
+        const char *env = getenv("GRID_MOL_SCHEME");
+        fprintf(stderr, "Unknown integrator %s, expected rk4, ssprk3, lsrk or imex\n", env ? env : MOL_SCHEME);
+        exit(1);
+    }
+    rk.allocate(storage.size(), scheme->nregs(), GRID_HUGEPAGES);
+    MolState y, reg[MOL_MAX_REGS];
+    mol_registry(y, reg, scheme->nregs());
+    printf("Method of lines, %s: %d RHS evaluations per step, registries: %d x %d variables, %.2f MB\n",
+           scheme->name(), scheme->stages(), rk.nregs, y.nvar, rk.bytes / (1024.0 * 1024.0));
+    report_page_placement("RK registers", rk.block, rk.bytes);
+    const double update_bytes = static_cast<double>(scheme->traffic()) * y.nvar * y.npts * sizeof(float);
+    printf("Stage updates: %.2f MB streamed per step\n", update_bytes / (1024.0 * 1024.0));
+#if GRID_DERIV_CACHE
+    dcache.allocate(storage.size(), GRID_HUGEPAGES);
+    printf("Derivative cache: 3 x %d fields + %d Hessians + %d advection terms, %.2f MB\n",
+           NUM_DERIV_FIELDS, NUM_HESS_FIELDS, NUM_ADV_FIELDS, dcache.bytes / (1024.0 * 1024.0));
+    report_page_placement("derivative cache", dcache.block, dcache.bytes);
+#else
+    printf("Derivative cache disabled, first derivatives recomputed on use\n");
+#endif
+    apply_boundary_conditions(grid_obj);
+#if GRID_DERIV_CACHE
+    report_derivative_throughput<D>();
+#endif
+    ko_sigma = ko_dissipation_strength();
+    report_dissipation_overhead<D>();
+#if GRID_SPECTRAL
+    report_spectral_accuracy();
+    report_chebyshev_accuracy();
+#endif
+
+    BSSNSystem<D> system(*this, scheme->imex());
+    for (int step = 0; step < nSteps; step++) {
+        auto step_start = std::chrono::high_resolution_clock::now();
+        max_speed_valid = false;
+        dt = computeCFL_dt(CFL);
+        apply_boundary_conditions(grid_obj);
+#pragma omp parallel
+        scheme->step(system, y, reg, dt);
+
+        std::chrono::duration<double> step_time = std::chrono::high_resolution_clock::now() - step_start;
+        total_time += step_time.count();
+        printf("Step %d wall time: %.3f s (%.2f ns/cell)\n", step, step_time.count(),
+               1e9 * step_time.count() / (static_cast<double>(nx_) * ny_ * nz_));
+
+#pragma omp single nowait
+        {
+            logger_evolve(grid_obj, dt, step);
+            export_gamma_slice(grid_obj, ny_ / 2, dt);
+            grid_obj.appendConstraintL2ToCSV("constraints_evolution.csv", grid_obj.time);
+            if (step == nSteps - 1) {
+                printf("Exporting slices\n");
+                export_K_slice(grid_obj, ny_ / 2);
+                export_gauge_slice(grid_obj, ny_ / 2);
+                gridTensor.export_christoffel_slice(grid_obj, nx_ / 2);
+                export_K_3D(grid_obj);
+            }
+        }
+
+        grid_obj.time += dt;
+    }
+    if (nSteps > 0)
+        printf("Integrator %s: %.3f s per step (%.2f ns/cell), %.2f MB of registers, "
+               "%.2f MB of stage updates per step\n", scheme->name(), total_time / nSteps,
+               1e9 * total_time / nSteps / (static_cast<double>(nx_) * ny_ * nz_),
+               rk.bytes / (1024.0 * 1024.0), update_bytes / (1024.0 * 1024.0));
+}
+
+#define INSTANTIATE_EVOLVE_MOL(N) \
+	template void Grid::evolve_mol<GridDims<N>>(Grid &, float, int);
+GRID_FAST_SIZES(INSTANTIATE_EVOLVE_MOL)
+INSTANTIATE_EVOLVE_MOL(0)
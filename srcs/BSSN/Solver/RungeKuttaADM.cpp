@@ -6,15 +6,15 @@ void Grid::logger_evolve(Grid &grid_obj, float dt, int nstep)
 	printf("=============================================\n");
 	printf("Time step: %f, nstep: %d\n", dt, nstep);
 	printf("=============================================\n");
-	printf("alpha: %e\n", cell.gauge.alpha);
-	printf("beta: %e %e %e\n", cell.gauge.beta[0], cell.gauge.beta[1], cell.gauge.beta[2]);
+	printf("alpha: %e\n", grid_obj.at(F_ALPHA, 0, 0, 0));
+	printf("beta: %e %e %e\n", grid_obj.at(F_BETA0, 0, 0, 0), grid_obj.at(F_BETA1, 0, 0, 0), grid_obj.at(F_BETA2, 0, 0, 0));
 	printf("Hamiltonian: %e\n", cell.matter.hamiltonian);
 	printf("Momentum: %e %e %e\n", cell.matter.momentum[0], cell.matter.momentum[1], cell.matter.momentum[2]);
 	printf("dtAtilde:\n");
 	for (int i = 0; i < 3; i++)
-		printf("	  %e %e %e\n", cell.atilde.dt_Atilde[i][0], \
-								   cell.atilde.dt_Atilde[i][1], 
-								   cell.atilde.dt_Atilde[i][2]);
+		printf("	  %e %e %e\n", cell.atilde.dt_Atilde(i, 0), \
+								   cell.atilde.dt_Atilde(i, 1), 
+								   cell.atilde.dt_Atilde(i, 2));
 	printf("Chi: %e\n", cell.dt_chi);
 	printf("=============================================\n");
 	printf("\n\n");
@@ -22,108 +22,189 @@ void Grid::logger_evolve(Grid &grid_obj, float dt, int nstep)
 
 
 
-void Grid::evolve(Grid &grid_obj, float dtInitial, int nSteps) {
-    initialize_grid();
+/*
+ * Steps the RK loop with the extents taken from D: for the GRID_FAST_SIZES
+ * resolutions the RHS kernels run fully specialised, everything else goes
+ * through the runtime GridDims<0> instantiation. Each step runs the
+ * RK_STAGES stages of the integrator GRID_LSRK selects. A stage is one
+ * sweep over the physical points that evaluates the RHS of the interior
+ * and folds it into the stage update on the spot (storeStage()), boundary
+ * points being carried over by holdStagePoint(); updateStageState() then
+ * only rotates pointers for RK4. The constraints are diagnostics only and
+ * are evaluated on the last stage. The last stage also reduces the
+ * per-axis characteristic speeds of the new state row by row, which sets
+ * the next step's CFL dt without another pass. With GRID_ADAPTIVE it
+ * reduces the weighted error of the attempt as well, and a rejected
+ * attempt is undone and retried at the dt the controller proposes.
+ */
+template <typename D>
+void Grid::evolve_steps(Grid &grid_obj, float dtInitial, int nSteps) {
     GridTensor gridTensor;
     float CFL = 0.5;
     float dt = dtInitial;
     float hamiltonian;
     float momentum[3];
-	float L = 9.0;
-    float x_min = -L, x_max = L;
-    float y_min = -L, y_max = L;
-    float z_min = -L, z_max = L;
-
+    const int nx = D::nx(grid_obj), ny = D::ny(grid_obj), nz = D::nz(grid_obj);
+    double total_time = 0.0;
+
+    rk.allocate(storage.size(), RK_NREGS, GRID_HUGEPAGES);
+    printf("%s, %d stages, registers: %d x %d fields, %.2f MB\n", RK_NAME, RK_STAGES, rk.nregs,
+           (int)NUM_FIELDS, rk.bytes / (1024.0 * 1024.0));
+    report_page_placement("RK registers", rk.block, rk.bytes);
+    const double update_bytes = static_cast<double>(stage_traffic_bytes(storage.size()));
+    printf("Stage updates: %.2f MB streamed per step\n", update_bytes / (1024.0 * 1024.0));
+#if GRID_DERIV_CACHE
+    dcache.allocate(storage.size(), GRID_HUGEPAGES);
+    printf("Derivative cache: 3 x %d fields + %d Hessians + %d advection terms, %.2f MB\n",
+           NUM_DERIV_FIELDS, NUM_HESS_FIELDS, NUM_ADV_FIELDS, dcache.bytes / (1024.0 * 1024.0));
+    report_page_placement("derivative cache", dcache.block, dcache.bytes);
+#else
+    printf("Derivative cache disabled, first derivatives recomputed on use\n");
+#endif
+    apply_boundary_conditions(grid_obj);
+#if GRID_DERIV_CACHE
+    report_derivative_throughput<D>();
+#endif
+    ko_sigma = ko_dissipation_strength();
+    report_dissipation_overhead<D>();
+#if GRID_SPECTRAL
+    report_spectral_accuracy();
+    report_chebyshev_accuracy();
+#endif
+
+    StepControl ctl = step_control();
+#if GRID_ADAPTIVE
+    dt = computeCFL_dt(CFL);
+    printf("Step control: rtol %.1e, atol %.1e, Courant limit %.2f\n", ctl.rtol, ctl.atol, RK_CFL_MAX);
+#endif
 
-    float dx = (x_max - x_min) / (NX - 1);
-    float dy = (y_max - y_min) / (NY - 1);
-    float dz = (z_max - z_min) / (NZ - 1);
     for (int step = 0; step < nSteps; step++) {
+        auto step_start = std::chrono::high_resolution_clock::now();
+#if GRID_ADAPTIVE
+        const float dt_max = computeCFL_dt(RK_CFL_MAX);
+        dt = std::min(dt, dt_max);
+#else
         dt = computeCFL_dt(CFL);
+#endif
         apply_boundary_conditions(grid_obj);
 
+        float dt_next = dt;
+        bool accepted = false;
+#if GRID_ADAPTIVE
+        int attempts = 0;
+#endif
+        while (!accepted) {
+            dt = dt_next;
+            double err_sum = 0.0;
+            float speed[3] = { 0.0f, 0.0f, 0.0f };
 #pragma omp parallel
-        {
-            auto forEachCell = [&](auto func) {
-#pragma omp for collapse(3) schedule(runtime)
-                for (int i = 1; i < NX - 1; i++) {
-                    for (int j = 1; j < NY - 1; j++) {
-                        for (int k = 1; k < NZ - 1; k++) {
-							float x = x_min + i*DX;
-                            float y = y_min + j*DY;
-                            float z = z_min + k*DZ;
-                            func(i, j, k);
+            {
+                double err_local = 0.0;
+                float speed_local[3] = { 0.0f, 0.0f, 0.0f };
+                for (int stage = 0; stage < RK_STAGES; stage++) {
+                    const bool last = stage == RK_STAGES - 1;
+                    if (stage > 0)
+                        fill_ghosts();
+#if GRID_DERIV_CACHE
+                    fill_derivative_cache<D>();
+#endif
+                    for_each_row(0, nx, 0, ny, 0, nz, [&](int i, int j, int kb, int ke) {
+                        const bool face = i == 0 || i == nx - 1 || j == 0 || j == ny - 1;
+                        for (int k = kb; k < ke; k++) {
+                            if (face || k == 0 || k == nz - 1) {
+                                holdStagePoint(stage, i, j, k);
+                                continue;
+                            }
+                            compute_time_derivatives<D>(grid_obj, i, j, k);
+                            float d_alpha_dt, d_beta_dt[3];
+                            compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
+                            if (last)
+                                compute_constraints(grid_obj, i, j, k, hamiltonian, momentum);
+                            err_local += storeStage<D>(stage, dt, i, j, k, d_alpha_dt, d_beta_dt, ctl);
                         }
-                    }
+                        if (last && !face)
+                            rowMaxSpeed<D>(i, j, std::max(kb, 1), std::min(ke, nz - 1), speed_local);
+                    });
+                    updateStageState(stage, dt);
                 }
-            };
-
-            forEachCell([&](int i, int j, int k) {
-                copyInitialState(globalGrid[i][j][k]);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                compute_time_derivatives(grid_obj, i, j, k);
-                float d_alpha_dt, d_beta_dt[3];
-                compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
-                compute_constraints(grid_obj, i, j, k, hamiltonian, momentum);
-                storeStage(globalGrid[i][j][k], 0, d_alpha_dt, d_beta_dt);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                updateIntermediateState(globalGrid[i][j][k], 0.5 * dt, 0);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                compute_time_derivatives(grid_obj, i, j, k);
-                float d_alpha_dt, d_beta_dt[3];
-                compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
-                storeStage(globalGrid[i][j][k], 1, d_alpha_dt, d_beta_dt);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                updateIntermediateState(globalGrid[i][j][k], 0.5 * dt, 1);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                compute_time_derivatives(grid_obj, i, j, k);
-                float d_alpha_dt, d_beta_dt[3];
-                compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
-                compute_constraints(grid_obj, i, j, k, hamiltonian, momentum);
-                storeStage(globalGrid[i][j][k], 2, d_alpha_dt, d_beta_dt);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                updateIntermediateState(globalGrid[i][j][k], dt, 2);
-            });
-            forEachCell([&](int i, int j, int k) {
-                compute_time_derivatives(grid_obj, i, j, k);
-                float d_alpha_dt, d_beta_dt[3];
-                compute_gauge_derivatives(grid_obj, i, j, k, d_alpha_dt, d_beta_dt);
-                compute_constraints(grid_obj, i, j, k, hamiltonian, momentum);
-                storeStage(globalGrid[i][j][k], 3, d_alpha_dt, d_beta_dt);
-            });
-
-            forEachCell([&](int i, int j, int k) {
-                combineStages(globalGrid[i][j][k], dt);
-            });
+                #pragma omp critical (stage_reduction)
+                {
+                    err_sum += err_local;
+                    for (int m = 0; m < 3; m++)
+                        speed[m] = std::max(speed[m], speed_local[m]);
+                }
+            }
+#if GRID_ADAPTIVE
+            const float err = stepError(err_sum);
+            accepted = ctl.update(err, dt_next, dt_max);
+            if (!accepted) {
+                printf("Step %d rejected: dt %.3e, error %.3f, retrying with dt %.3e\n", step, dt, err, dt_next);
+                rejectStep();
+                if (++attempts >= RK_MAX_REJECTS || !(dt_next >= RK_DT_MIN * dt_max)) {
+                    fprintf(stderr, "Step %d failed: %d attempts rejected, last error %.3e, dt %.3e "
+                            "(Courant dt %.3e)\n", step, attempts, err, dt_next, dt_max);
+                    exit(1);
+                }
+            } else {
+                printf("Step %d accepted: dt %.3e, error %.3f\n", step, dt, err);
+            }
+#else
+            (void)err_sum;
+            accepted = true;
+#endif
+            if (accepted) {
+                for (int m = 0; m < 3; m++)
+                    max_speed[m] = speed[m];
+                max_speed_valid = true;
+            }
         }
 
+        std::chrono::duration<double> step_time = std::chrono::high_resolution_clock::now() - step_start;
+        total_time += step_time.count();
+        printf("Step %d wall time: %.3f s (%.2f ns/cell)\n", step, step_time.count(),
+               1e9 * step_time.count() / (static_cast<double>(nx) * ny * nz));
+
 #pragma omp single nowait
         {
             logger_evolve(grid_obj, dt, step);
-			float current_time = step * dt;
-			export_gamma_slice(grid_obj, NY / 2, dt);
+			float current_time = grid_obj.time;
+			export_gamma_slice(grid_obj, ny / 2, dt);
 			grid_obj.appendConstraintL2ToCSV("constraints_evolution.csv", current_time);
 			if (step == nSteps - 1) {
                 printf("Exporting slices\n");
-                export_K_slice(grid_obj, NY / 2);
-                export_gauge_slice(grid_obj, NY / 2);
-                gridTensor.export_christoffel_slice(grid_obj, NX / 2);
+                export_K_slice(grid_obj, ny / 2);
+                export_gauge_slice(grid_obj, ny / 2);
+                gridTensor.export_christoffel_slice(grid_obj, nx / 2);
                 export_K_3D(grid_obj);
             }
         }
 
         grid_obj.time += dt;
+#if GRID_ADAPTIVE
+        dt = dt_next;
+#endif
     }
+#if GRID_ADAPTIVE
+    printf("Step control: %d steps accepted, %d rejected, t = %.6e\n", ctl.accepted, ctl.rejected,
+           grid_obj.time);
+#endif
+    if (nSteps > 0)
+        printf("Integrator %s: %.3f s per step (%.2f ns/cell), %.2f MB of registers, "
+               "%.2f MB of stage updates per step\n", RK_NAME, total_time / nSteps,
+               1e9 * total_time / nSteps / (static_cast<double>(nx) * ny * nz),
+               rk.bytes / (1024.0 * 1024.0), update_bytes / (1024.0 * 1024.0));
+}
+
+void Grid::evolve(Grid &grid_obj, float dtInitial, int nSteps) {
+    initialize_grid();
+    dispatch_dims(grid_obj, [&](auto dims) {
+        using D = decltype(dims);
+        printf("Grid %dx%dx%d: %s kernels, order %d finite differences\n", nx, ny, nz,
+               D::fixed ? "specialised fixed-size" : "generic runtime-size", FD_ORDER);
+#if GRID_MOL
+        evolve_mol<D>(grid_obj, dtInitial, nSteps);
+#else
+        evolve_steps<D>(grid_obj, dtInitial, nSteps);
+#endif
+    });
 }
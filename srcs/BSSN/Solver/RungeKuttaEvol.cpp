@@ -2,23 +2,23 @@
 
 
 void apply_asymptotic_boundary_conditions(Grid &grid_obj, float R_max) {
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            for (int k = 0; k < NZ; k++) {
-                float x = i * DX ;
-                float y = j * DY ;
-                float z = k * DZ ;
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            for (int k = 0; k < grid_obj.nz; k++) {
+                float x = i * grid_obj.dx ;
+                float y = j * grid_obj.dy ;
+                float z = k * grid_obj.dz ;
                 float r = sqrt(x * x + y * y + z * z);
 
                 if (r > R_max) {
-                    grid_obj.getCell(i, j, k).gauge.alpha = 1.0;
-                    grid_obj.getCell(i, j, k).gauge.beta[0] = 0.0;
-                    grid_obj.getCell(i, j, k).gauge.beta[1] = 0.0;
-                    grid_obj.getCell(i, j, k).gauge.beta[2] = 0.0;
+                    grid_obj.at(F_ALPHA, i, j, k) = 1.0;
+                    grid_obj.at(F_BETA0, i, j, k) = 0.0;
+                    grid_obj.at(F_BETA1, i, j, k) = 0.0;
+                    grid_obj.at(F_BETA2, i, j, k) = 0.0;
 
                     for (int a = 0; a < 3; a++) {
                         for (int b = 0; b < 3; b++) {
-                            grid_obj.getCell(i, j, k).curv.K[a][b] = 0.0;
+                            grid_obj.at(F_K(a, b), i, j, k) = 0.0;
                         }
                     }
                 }
@@ -50,101 +50,434 @@ void apply_asymptotic_boundary_conditions(Grid &grid_obj, float R_max) {
 
 void apply_boundary_conditions(Grid &grid_obj) {
 	apply_asymptotic_boundary_conditions(grid_obj, 128.0);
-    for (int j = 0; j < NY; j++) {
-        for (int k = 0; k < NZ; k++) {
-            grid_obj.getCell(0, j, k) = grid_obj.getCell(1, j, k);
-            grid_obj.getCell(NX - 1, j, k) = grid_obj.getCell(NX - 2, j, k);
+    for (int j = 0; j < grid_obj.ny; j++) {
+        for (int k = 0; k < grid_obj.nz; k++) {
+            grid_obj.copyPoint(0, j, k, 1, j, k);
+            grid_obj.copyPoint(grid_obj.nx - 1, j, k, grid_obj.nx - 2, j, k);
         }
     }
 
-    for (int i = 0; i < NX; i++) {
-        for (int k = 0; k < NZ; k++) {
-            grid_obj.getCell(i, 0, k) = grid_obj.getCell(i, 1, k);
-            grid_obj.getCell(i, NY - 1, k) = grid_obj.getCell(i, NY - 2, k);
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int k = 0; k < grid_obj.nz; k++) {
+            grid_obj.copyPoint(i, 0, k, i, 1, k);
+            grid_obj.copyPoint(i, grid_obj.ny - 1, k, i, grid_obj.ny - 2, k);
         }
     }
 
-    for (int i = 0; i < NX; i++) {
-        for (int j = 0; j < NY; j++) {
-            grid_obj.getCell(i, j, 0) = grid_obj.getCell(i, j, 1);
-            grid_obj.getCell(i, j, NZ - 1) = grid_obj.getCell(i, j, NZ - 2);
+    for (int i = 0; i < grid_obj.nx; i++) {
+        for (int j = 0; j < grid_obj.ny; j++) {
+            grid_obj.copyPoint(i, j, 0, i, j, 1);
+            grid_obj.copyPoint(i, j, grid_obj.nz - 1, i, j, grid_obj.nz - 2);
         }
     }
+    grid_obj.fill_ghosts();
 }
 
-
-void Grid::copyInitialState(Cell2D &cell) {
-    for (int a = 0; a < 3; a++) {
-        for (int b = 0; b < 3; b++) {
-            cell.geom.tilde_gamma0[a][b] = cell.geom.gamma[a][b];
-            cell.curv.K0[a][b]     = cell.curv.K[a][b];
-			cell.atilde.Atilde0[a][b] = cell.atilde.Atilde[a][b];
-        }
-    }
-    cell.gauge.alpha0 = cell.gauge.alpha;
-    for (int m = 0; m < 3; m++) {
-        cell.gauge.beta0[m] = cell.gauge.beta[m];
+/*
+ * FD closure of one line into its GHOST layers on both ends: each ghost is
+ * the degree FD_ORDER - 1 extrapolation of the first (last) FD_ORDER points,
+ * see FDClosure. This is the whole boundary treatment seen by the interior
+ * stencils, which are otherwise FD_ORDER at every physical point.
+ * pos(p) is the array offset of coordinate p along the line.
+ */
+template <typename Pos>
+static inline void extrapolate_line(float *u, int n, Pos pos) {
+    for (int g = 1; g <= GHOST; g++) {
+        u[pos(-g)] = FD::extrapolate([&](int m) { return u[pos(m)]; }, g);
+        u[pos(n - 1 + g)] = FD::extrapolate([&](int m) { return u[pos(n - 1 - m)]; }, g);
     }
 }
 
-void Grid::updateIntermediateState(Cell2D &cell, float dtCoeff, int stageIndex) {
-    for (int a = 0; a < 3; a++) {
-        for (int b = 0; b < 3; b++) {
-            cell.geom.tilde_gamma[a][b] = cell.geom.tilde_gamma0[a][b] + dtCoeff * cell.gammaStage[stageIndex][a][b];
-            cell.curv.K[a][b]     = cell.curv.K0[a][b]     + dtCoeff * cell.KStage[stageIndex][a][b];
+/*
+ * Refresh the ghost layers of every evolved field. Axes are done in turn
+ * (x on the physical y-z face, then y including the x ghosts, then z on
+ * the full padded x-y plane) so edges and corners, needed by the mixed
+ * second derivatives, come out consistent. Works as an orphaned worksharing
+ * construct, inside or outside a parallel region.
+ */
+void Grid::fill_ghosts() {
+    const int g = storage.ghost;
+
+    #pragma omp for collapse(3) schedule(static)
+    for (int f = 0; f < NUM_FIELDS; f++)
+        for (int j = 0; j < ny; j++)
+            for (int k = 0; k < nz; k++)
+                extrapolate_line(storage.fields[f], nx, [&](int p) { return idx(p, j, k); });
+
+    #pragma omp for collapse(3) schedule(static)
+    for (int f = 0; f < NUM_FIELDS; f++)
+        for (int i = -g; i < nx + g; i++)
+            for (int k = 0; k < nz; k++)
+                extrapolate_line(storage.fields[f], ny, [&](int p) { return idx(i, p, k); });
+
+    #pragma omp for collapse(3) schedule(static)
+    for (int f = 0; f < NUM_FIELDS; f++)
+        for (int i = -g; i < nx + g; i++)
+            for (int j = -g; j < ny + g; j++)
+                extrapolate_line(storage.fields[f], nz, [&](int p) { return idx(i, j, p); });
+}
+
+
+/*
+ * The helpers below run inside the evolve() parallel region. Each one
+ * streams whole SoA arrays with a static schedule, so every thread touches
+ * the same slice of every field it first-touched at allocation.
+ */
+
+/* fields advanced by the integrators: all but Atilde, which is rebuilt from K */
+static inline bool rk_integrated(int f) {
+    return f < F_ATXX || f > F_ATZZ;
+}
+
+#if GRID_LSRK
+/*
+ * 2N-storage RK4(5) of Carpenter and Kennedy (NASA TM-109112, 1994): per
+ * stage s, dq = A[s] dq + dt f(y), then y += B[s] dq. A[0] = 0, so the
+ * first stage needs no clear of the register.
+ */
+static const float LSRK_A[5] = {
+    0.0f,
+    -567301805773.0f / 1357537059087.0f,
+    -2404267990393.0f / 2016746695238.0f,
+    -3550918686646.0f / 2091501179385.0f,
+    -1275806237668.0f / 842570457699.0f
+};
+static const float LSRK_B[5] = {
+    1432997174477.0f / 9575080441755.0f,
+    5161836677717.0f / 13612068292357.0f,
+    1720146321549.0f / 2090206949498.0f,
+    3134564353537.0f / 4481467310338.0f,
+    2277821191437.0f / 14882151754819.0f
+};
+#elif GRID_ADAPTIVE
+/*
+ * Bogacki-Shampine 3(2): stage s + 1 starts from y0 + BS_C[s] dt k_s,
+ * y1 = y0 + dt sum BS_B[s] k_s is the third order solution and the error
+ * estimate dt sum BS_E[s] k_s takes the fourth RHS, evaluated at y1.
+ */
+static const float BS_C[2] = {0.5f, 0.75f};
+static const float BS_B[3] = {2.0f / 9.0f, 1.0f / 3.0f, 4.0f / 9.0f};
+static const float BS_E[4] = {-5.0f / 72.0f, 1.0f / 12.0f, 1.0f / 9.0f, -1.0f / 8.0f};
+#else
+/* classic RK4: weight of stage s in the accumulator, abscissa of stage s + 1 */
+static const float RK4_WEIGHT[4] = {1.0f, 2.0f, 2.0f, 1.0f};
+static const float RK4_COEFF[3]  = {0.5f, 0.5f, 1.0f};
+#endif
+
+/*
+ * Fold the RHS of one point into the integrator, with the Kreiss-Oliger
+ * term of each integrated field added while the point is at hand, so
+ * dissipation costs no sweep of its own. RK4 updates the accumulator and
+ * writes the next stage state y0 + c dt r of the point (after the last
+ * stage, the new state y0 + dt/6 (acc + r) over RK_Y0 in place); nothing
+ * reads those arrays with a stencil during the sweep, so the whole stage
+ * update happens here and no separate pass is needed. The 2N-storage
+ * scheme folds dt r into LSRK_DQ. The embedded pair builds its stage
+ * states the same way, with RK_ACC holding the y1 increment and RK_ERR the
+ * error estimate; its last stage only reads them and returns the point's
+ * sum of squared weighted errors, the point's share of the fused error
+ * reduction (0 for every other stage and scheme). chi is driven by the
+ * dt_chi compute_time_derivatives() leaves in the cell; Atilde is rebuilt
+ * from K and not touched.
+ */
+template <typename D>
+float Grid::storeStage(int stage, float dt, int i, int j, int k, float d_alpha_dt, float d_beta_dt[3],
+                       const StepControl &ctl) {
+    const Cell2D &cell = getCell(i, j, k);
+    const size_t n = idx(i, j, k);
+    const float sigma = ko_sigma;
+    auto ko = [&](int f) {
+        return sigma != 0.0f ? sigma * ko_dissipation<D>(*this, storage.fields[f], i, j, k) : 0.0f;
+    };
+#if GRID_LSRK
+    float *const *dq = rk.reg[LSRK_DQ];
+    const float a = LSRK_A[stage];
+    auto store = [&](int f, float r) {
+        dq[f][n] = (stage == 0 ? 0.0f : a * dq[f][n]) + dt * r;
+    };
+#elif GRID_ADAPTIVE
+    float err = 0.0f;
+    auto store = [&](int f, float r) {
+        float *acc = rk.reg[RK_ACC][f];
+        float *e = rk.reg[RK_ERR][f];
+        const float *y0 = stage == 0 ? storage.fields[f] : rk.reg[RK_Y0][f];
+        if (stage == RK_STAGES - 1) {
+            const float y1 = storage.fields[f][n];
+            const float w = (e[n] + dt * BS_E[stage] * r)
+                          / (ctl.atol + ctl.rtol * std::max(std::fabs(y0[n]), std::fabs(y1)));
+            err += w * w;
+            return;
+        }
+        e[n] = (stage == 0 ? 0.0f : e[n]) + dt * BS_E[stage] * r;
+        if (stage == 2) {
+            rk.reg[RK_STAGE][f][n] = y0[n] + acc[n] + dt * BS_B[stage] * r;
+            return;
+        }
+        acc[n] = (stage == 0 ? 0.0f : acc[n]) + dt * BS_B[stage] * r;
+        rk.reg[RK_STAGE][f][n] = y0[n] + BS_C[stage] * dt * r;
+    };
+#else
+    const bool last = stage == RK_STAGES - 1;
+    const float w = RK4_WEIGHT[stage];
+    const float h = last ? dt / 6.0f : RK4_COEFF[stage] * dt;
+    auto store = [&](int f, float r) {
+        float *acc = rk.reg[RK_ACC][f];
+        if (last) {
+            rk.reg[RK_Y0][f][n] += h * (acc[n] + r);
+            return;
         }
+        const float *y0 = stage == 0 ? storage.fields[f] : rk.reg[RK_Y0][f];
+        acc[n] = stage == 0 ? r : acc[n] + w * r;
+        rk.reg[RK_STAGE][f][n] = y0[n] + h * r;
+    };
+#endif
+    for (int c = 0; c < SYM_NCOMP; c++) {
+        store(F_GTXX + c, cell.dgt[c] + ko(F_GTXX + c));
+        store(F_KXX + c, cell.curv.dKt[c] + ko(F_KXX + c));
     }
-    cell.gauge.alpha = cell.gauge.alpha0 + dtCoeff * cell.gauge.alphaStage[stageIndex];
-    for (int m = 0; m < 3; m++) {
-        cell.gauge.beta[m] = cell.gauge.beta0[m] + dtCoeff * cell.gauge.betaStage[stageIndex][m];
+    store(F_ALPHA, d_alpha_dt + ko(F_ALPHA));
+    for (int m = 0; m < 3; m++)
+        store(F_BETA(m), d_beta_dt[m] + ko(F_BETA(m)));
+    store(F_CHI, cell.dt_chi + ko(F_CHI));
+#if GRID_ADAPTIVE
+    return err;
+#else
+    (void)ctl;
+    return 0.0f;
+#endif
+}
+
+#define INSTANTIATE_STORE_STAGE(N) \
+	template float Grid::storeStage<GridDims<N>>(int, float, int, int, int, float, float[3], \
+	                                             const StepControl &);
+GRID_FAST_SIZES(INSTANTIATE_STORE_STAGE)
+INSTANTIATE_STORE_STAGE(0)
+
+/*
+ * Physical boundary point of the stage sweep: it gets no RHS, so RK4
+ * carries its integrated fields into the next stage state unchanged (the
+ * last stage writes RK_Y0, which already holds them). The 2N-storage
+ * register stays zero there, nothing to do.
+ */
+void Grid::holdStagePoint(int stage, int i, int j, int k) {
+#if GRID_LSRK
+    (void)stage;
+    (void)i;
+    (void)j;
+    (void)k;
+#else
+    if (stage == RK_STAGES - 1)
+        return;
+    const size_t n = idx(i, j, k);
+    for (int f = 0; f < NUM_FIELDS; f++)
+        if (rk_integrated(f))
+            rk.reg[RK_STAGE][f][n] = (stage == 0 ? storage.fields[f] : rk.reg[RK_Y0][f])[n];
+#endif
+}
+
+/*
+ * Per-axis characteristic speed maximum of the state a step ends with, over
+ * the row (i, j, kb..ke), folded into speed. Called by the last stage sweep
+ * right after the row is stored, so the new state (RK_Y0 for RK4, y + B dq
+ * for the 2N scheme, the fields themselves for the embedded pair) is read
+ * while still in cache. Rows are contiguous in k in both layouts.
+ */
+template <typename D>
+void Grid::rowMaxSpeed(int i, int j, int kb, int ke, float speed[3]) const {
+    const ptrdiff_t o = D::offset(*this, i, j, kb);
+#if GRID_LSRK
+    const float b = LSRK_B[RK_STAGES - 1];
+    auto y = [&](int f, ptrdiff_t n) { return storage.fields[f][n] + b * rk.reg[LSRK_DQ][f][n]; };
+#elif GRID_ADAPTIVE
+    auto y = [&](int f, ptrdiff_t n) { return storage.fields[f][n]; };
+#else
+    auto y = [&](int f, ptrdiff_t n) { return rk.reg[RK_Y0][f][n]; };
+#endif
+    float vx = speed[0], vy = speed[1], vz = speed[2];
+    #pragma omp simd reduction(max: vx, vy, vz)
+    for (int k = 0; k < ke - kb; k++) {
+        const ptrdiff_t n = o + k;
+        const float beta[3] = { y(F_BETA0, n), y(F_BETA1, n), y(F_BETA2, n) };
+        float gt[SYM_NCOMP], v[3];
+        for (int c = 0; c < SYM_NCOMP; c++)
+            gt[c] = y(F_GTXX + c, n);
+        characteristic_speed(y(F_ALPHA, n), beta, y(F_CHI, n), gt, v);
+        vx = std::max(vx, v[0]);
+        vy = std::max(vy, v[1]);
+        vz = std::max(vz, v[2]);
     }
+    speed[0] = vx;
+    speed[1] = vy;
+    speed[2] = vz;
 }
 
-void Grid::storeStage(Cell2D &cell, int stage, float d_alpha_dt, float d_beta_dt[3]) {
-    for (int a = 0; a < 3; a++) {
-        for (int b = 0; b < 3; b++) {
-            cell.gammaStage[stage][a][b] = cell.dgt[a][b];
-            cell.KStage[stage][a][b]     = cell.curv.dKt[a][b];
-        }
+#define INSTANTIATE_ROW_MAX_SPEED(N) \
+	template void Grid::rowMaxSpeed<GridDims<N>>(int, int, int, int, float[3]) const;
+GRID_FAST_SIZES(INSTANTIATE_ROW_MAX_SPEED)
+INSTANTIATE_ROW_MAX_SPEED(0)
+
+/*
+ * Compulsory traffic of the stage updates over one step, in bytes: the
+ * register and state arrays the integrator streams on top of what the RHS
+ * reads anyway. RK4 reads the state and writes the accumulator and next
+ * state in stage 0, reads y0 and updates acc and the next state in the
+ * middle stages and reads acc and updates y0 in the last; the 2N scheme
+ * reads and writes dq in the sweep, then streams y and dq again in its
+ * update. The embedded pair adds the error accumulator to the RK4 pattern
+ * and its error stage only reads y0, y1 and RK_ERR.
+ */
+size_t Grid::stage_traffic_bytes(size_t npts) {
+    int nint = 0;
+    for (int f = 0; f < NUM_FIELDS; f++)
+        nint += rk_integrated(f);
+#if GRID_LSRK
+    const int arrays = (1 + 3) + (RK_STAGES - 1) * (2 + 3);
+#elif GRID_ADAPTIVE
+    const int arrays = 4 + 6 + 5 + 3;
+#else
+    const int arrays = 3 + 4 * (RK_STAGES - 2) + 3;
+#endif
+    return static_cast<size_t>(arrays) * nint * npts * sizeof(float);
+}
+
+/*
+ * Times one RHS evaluation over the interior (derivative cache fill plus
+ * the point kernels) against one Kreiss-Oliger sweep over the integrated
+ * fields, and prints the dissipation cost as a fraction of the RHS. The
+ * KO sweep writes the last allocated RK register (RK_STAGE, LSRK_DQ or the
+ * last registry of the method-of-lines scheme), which the first stage
+ * overwrites. Needs up to date ghosts; leaves the derivative
+ * cache invalid.
+ */
+template <typename D>
+void Grid::report_dissipation_overhead() {
+    if (ko_sigma == 0.0f) {
+        printf("Kreiss-Oliger dissipation off\n");
+        return;
     }
-    cell.gauge.alphaStage[stage] = d_alpha_dt;
-    for (int m = 0; m < 3; m++) {
-        cell.gauge.betaStage[stage][m] = d_beta_dt[m];
+    const int nx_ = D::nx(*this), ny_ = D::ny(*this), nz_ = D::nz(*this);
+    const float sigma = ko_sigma;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+#pragma omp parallel
+    {
+#if GRID_DERIV_CACHE
+        fill_derivative_cache<D>();
+#endif
+        for_each_row(1, nx_ - 1, 1, ny_ - 1, 1, nz_ - 1, [&](int i, int j, int kb, int ke) {
+            for (int k = kb; k < ke; k++) {
+                float d_alpha_dt, d_beta_dt[3];
+                compute_time_derivatives<D>(*this, i, j, k);
+                compute_gauge_derivatives(*this, i, j, k, d_alpha_dt, d_beta_dt);
+            }
+        });
     }
+    auto t1 = std::chrono::high_resolution_clock::now();
+#pragma omp parallel
+    for_each_row(1, nx_ - 1, 1, ny_ - 1, 1, nz_ - 1, [&](int i, int j, int kb, int ke) {
+        for (int f = 0; f < NUM_FIELDS; f++) {
+            if (!rk_integrated(f))
+                continue;
+            float *acc = rk.reg[rk.nregs - 1][f];
+            for (int k = kb; k < ke; k++)
+                acc[D::offset(*this, i, j, k)] = sigma * ko_dissipation<D>(*this, storage.fields[f], i, j, k);
+        }
+    });
+    auto t2 = std::chrono::high_resolution_clock::now();
+    dcache.valid = false;
+
+    const double rhs = std::chrono::duration<double>(t1 - t0).count();
+    const double ko = std::chrono::duration<double>(t2 - t1).count();
+    printf("Kreiss-Oliger order %d, sigma %.3f: %.3f ms per sweep, RHS %.3f ms, overhead %.1f%%\n",
+           KO_ORDER, sigma, 1e3 * ko, 1e3 * rhs, 100.0 * ko / rhs);
 }
 
-void Grid::combineStages(Cell2D &cell, float dt) {
-    for (int a = 0; a < 3; a++) {
-        for (int b = 0; b < 3; b++) {
-            cell.geom.tilde_gamma[a][b] = cell.geom.tilde_gamma0[a][b] +
-                (dt / 6.0) * (cell.gammaStage[0][a][b] +
-                              2.0 * cell.gammaStage[1][a][b] +
-                              2.0 * cell.gammaStage[2][a][b] +
-                              cell.gammaStage[3][a][b]);
-            cell.curv.K[a][b] = cell.curv.K0[a][b] +
-                (dt / 6.0) * (cell.KStage[0][a][b] +
-                              2.0 * cell.KStage[1][a][b] +
-                              2.0 * cell.KStage[2][a][b] +
-                              cell.KStage[3][a][b]);
-
-			cell.atilde.Atilde[a][b] = cell.atilde.Atilde0[a][b] +
-				(dt / 6.0) * (cell.atilde.AtildeStage[0][a][b] +
-						2.0 * cell.atilde.AtildeStage[1][a][b] +
-						2.0 * cell.atilde.AtildeStage[2][a][b] +
-						cell.atilde.AtildeStage[3][a][b]);
+#define INSTANTIATE_DISSIPATION_OVERHEAD(N) \
+	template void Grid::report_dissipation_overhead<GridDims<N>>();
+GRID_FAST_SIZES(INSTANTIATE_DISSIPATION_OVERHEAD)
+INSTANTIATE_DISSIPATION_OVERHEAD(0)
 
-        }
+#if GRID_LSRK
+/*
+ * Second half of 2N-storage stage s: y += B[s] dq for every integrated
+ * field, storeStage() having built dq during the RHS sweep. dq is zero
+ * off the interior, so boundary and ghost points keep their values. Atilde
+ * keeps its last rebuild from K. The stage derivative cache goes stale
+ * here and is refilled by the caller.
+ */
+void Grid::updateStageState(int stage, float dt) {
+    (void)dt;
+    const size_t npts = storage.size();
+    const float b = LSRK_B[stage];
+
+    #pragma omp single nowait
+    dcache.valid = false;
+
+    for (int f = 0; f < NUM_FIELDS; f++) {
+        if (!rk_integrated(f))
+            continue;
+        float *y = storage.fields[f];
+        const float *dq = rk.reg[LSRK_DQ][f];
+        #pragma omp for simd schedule(static) nowait
+        for (size_t n = 0; n < npts; n++)
+            y[n] += b * dq[n];
     }
-    cell.gauge.alpha = cell.gauge.alpha0 +
-        (dt / 6.0) * (cell.gauge.alphaStage[0] +
-                      2.0 * cell.gauge.alphaStage[1] +
-                      2.0 * cell.gauge.alphaStage[2] +
-                      cell.gauge.alphaStage[3]);
-    for (int m = 0; m < 3; m++) {
-        cell.gauge.beta[m] = cell.gauge.beta0[m] +
-            (dt / 6.0) * (cell.gauge.betaStage[0][m] +
-                          2.0 * cell.gauge.betaStage[1][m] +
-                          2.0 * cell.gauge.betaStage[2][m] +
-                          cell.gauge.betaStage[3][m]);
+    #pragma omp barrier
+}
+#else
+/*
+ * End of RK4 stage s, once the sweep has written the next stage state
+ * (after the last stage, the new state into RK_Y0): rotate the integrated
+ * field pointers so GridStorage::fields is what the next stage reads.
+ * The embedded pair's y1 is already in place after its third stage, the
+ * error stage leaves the pointers alone.
+ * After stage 0 the step-start state simply becomes RK_Y0, so it is never
+ * copied. Pointer swaps only, the data stays where it was first touched.
+ * The stage derivative cache goes stale here and is refilled by the caller.
+ */
+void Grid::updateStageState(int stage, float dt) {
+    (void)dt;
+    #pragma omp single
+    {
+        dcache.valid = false;
+        for (int f = 0; f < NUM_FIELDS; f++) {
+            if (!rk_integrated(f))
+                continue;
+            float *&y = storage.fields[f];
+            float *&y0 = rk.reg[RK_Y0][f];
+            float *&next = rk.reg[RK_STAGE][f];
+            if (stage == 0) {
+                float *start = y;
+                y = next;
+                next = y0;
+                y0 = start;
+            } else if (stage < RK_STAGES - 1) {
+                std::swap(y, next);
+            } else if (!GRID_ADAPTIVE) {
+                std::swap(y, y0);
+            }
+        }
     }
 }
+
+/*
+ * Throw away a rejected attempt of the embedded pair: the step-start
+ * state is still intact in RK_Y0, swap it back in. Serial, between
+ * attempts.
+ */
+void Grid::rejectStep() {
+    for (int f = 0; f < NUM_FIELDS; f++)
+        if (rk_integrated(f))
+            std::swap(storage.fields[f], rk.reg[RK_Y0][f]);
+    dcache.valid = false;
+}
+
+/* weighted RMS over the integrated fields of the interior from the reduced sum of squares */
+float Grid::stepError(double sum) const {
+    int nint = 0;
+    for (int f = 0; f < NUM_FIELDS; f++)
+        nint += rk_integrated(f);
+    const double npts = static_cast<double>(nx - 2) * (ny - 2) * (nz - 2) * nint;
+    return static_cast<float>(std::sqrt(sum / npts));
+}
+#endif
@@ -5,13 +5,13 @@ void GridTensor::compute_Atilde(Grid &grid_obj, int i, int j, int k) {
     float Ktrace = 0.0;
     for (int a = 0; a < 3; ++a) {
         for (int b = 0; b < 3; ++b) {
-            Ktrace += cell.geom.gamma_inv[a][b] * cell.curv.K[a][b];
+            Ktrace += cell.geom.gamma_inv[a][b] * grid_obj.at(F_K(a, b), i, j, k);
         }
     }
     for (int a = 0; a < 3; ++a) {
         for (int b = 0; b < 3; ++b) {
-            float Aij = cell.curv.K[a][b] - (1.0/3.0) * Ktrace * cell.geom.gamma[a][b];
-            cell.atilde.Atilde[a][b] = std::sqrt(cell.chi) * Aij; 
+            float Aij = grid_obj.at(F_K(a, b), i, j, k) - (1.0/3.0) * Ktrace * cell.geom.gamma[a][b];
+            grid_obj.at(F_AT(a, b), i, j, k) = std::sqrt(grid_obj.at(F_CHI, i, j, k)) * Aij; 
         }
     }
 }
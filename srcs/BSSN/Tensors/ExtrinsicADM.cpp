@@ -13,17 +13,17 @@ void GridTensor::compute_extrinsic_curvature(Grid &grid_obj, int i, int j, int k
                                              float dx, float dy, float dz) {
     Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
     float partialBeta[3][3];
-    partialBeta[0][0] = (grid_obj.getCell(i+1, j, k).gauge.beta[0] - grid_obj.getCell(i-1, j, k).gauge.beta[0]) / (2.0 * dx);
-    partialBeta[0][1] = (grid_obj.getCell(i, j+1, k).gauge.beta[0] - grid_obj.getCell(i, j-1, k).gauge.beta[0]) / (2.0 * dy);
-    partialBeta[0][2] = (grid_obj.getCell(i, j, k+1).gauge.beta[0] - grid_obj.getCell(i, j, k-1).gauge.beta[0]) / (2.0 * dz);
+    partialBeta[0][0] = (grid_obj.at(F_BETA0, i+1, j, k) - grid_obj.at(F_BETA0, i-1, j, k)) / (2.0 * dx);
+    partialBeta[0][1] = (grid_obj.at(F_BETA0, i, j+1, k) - grid_obj.at(F_BETA0, i, j-1, k)) / (2.0 * dy);
+    partialBeta[0][2] = (grid_obj.at(F_BETA0, i, j, k+1) - grid_obj.at(F_BETA0, i, j, k-1)) / (2.0 * dz);
 
-    partialBeta[1][0] = (grid_obj.getCell(i+1, j, k).gauge.beta[1] - grid_obj.getCell(i-1, j, k).gauge.beta[1]) / (2.0 * dx);
-    partialBeta[1][1] = (grid_obj.getCell(i, j+1, k).gauge.beta[1] - grid_obj.getCell(i, j-1, k).gauge.beta[1]) / (2.0 * dy);
-    partialBeta[1][2] = (grid_obj.getCell(i, j, k+1).gauge.beta[1] - grid_obj.getCell(i, j, k-1).gauge.beta[1]) / (2.0 * dz);
+    partialBeta[1][0] = (grid_obj.at(F_BETA1, i+1, j, k) - grid_obj.at(F_BETA1, i-1, j, k)) / (2.0 * dx);
+    partialBeta[1][1] = (grid_obj.at(F_BETA1, i, j+1, k) - grid_obj.at(F_BETA1, i, j-1, k)) / (2.0 * dy);
+    partialBeta[1][2] = (grid_obj.at(F_BETA1, i, j, k+1) - grid_obj.at(F_BETA1, i, j, k-1)) / (2.0 * dz);
 
-    partialBeta[2][0] = (grid_obj.getCell(i+1, j, k).gauge.beta[2] - grid_obj.getCell(i-1, j, k).gauge.beta[2]) / (2.0 * dx);
-    partialBeta[2][1] = (grid_obj.getCell(i, j+1, k).gauge.beta[2] - grid_obj.getCell(i, j-1, k).gauge.beta[2]) / (2.0 * dy);
-    partialBeta[2][2] = (grid_obj.getCell(i, j, k+1).gauge.beta[2] - grid_obj.getCell(i, j, k-1).gauge.beta[2]) / (2.0 * dz);
+    partialBeta[2][0] = (grid_obj.at(F_BETA2, i+1, j, k) - grid_obj.at(F_BETA2, i-1, j, k)) / (2.0 * dx);
+    partialBeta[2][1] = (grid_obj.at(F_BETA2, i, j+1, k) - grid_obj.at(F_BETA2, i, j-1, k)) / (2.0 * dy);
+    partialBeta[2][2] = (grid_obj.at(F_BETA2, i, j, k+1) - grid_obj.at(F_BETA2, i, j, k-1)) / (2.0 * dz);
 
     compute_christoffel_3D(grid_obj, i, j, k, cell.conn.Christoffel);
 
@@ -31,18 +31,18 @@ void GridTensor::compute_extrinsic_curvature(Grid &grid_obj, int i, int j, int k
     for (int i_idx = 0; i_idx < 3; ++i_idx) {
         for (int j_idx = 0; j_idx < 3; ++j_idx) {
             for (int k_idx = 0; k_idx < 3; ++k_idx) {
-                GammaBeta[i_idx][j_idx] += cell.conn.Christoffel[i_idx][j_idx][k_idx] * cell.gauge.beta[k_idx];
+                GammaBeta[i_idx][j_idx] += cell.conn.Christoffel[i_idx][j_idx][k_idx] * grid_obj.at(F_BETA(k_idx), i, j, k);
             }
         }
     }
 
-    float alpha = cell.gauge.alpha;
+    float alpha = grid_obj.at(F_ALPHA, i, j, k);
 
-    for (int a = 0; a < 3; ++a) {
-        for (int b = 0; b < 3; ++b) {
-            float sym_grad_beta = partialBeta[a][b] + partialBeta[b][a];
-            float correction = sym_grad_beta - 2.0 * GammaBeta[a][b];
-            cell.curv.K[a][b] = -0.5 / alpha * (cell.dgt[a][b] - correction);
-        }
+    /* K is stored packed, so only the symmetric part of GammaBeta survives */
+    for (int c = 0; c < SYM_NCOMP; ++c) {
+        const int a = SYM_A[c], b = SYM_B[c];
+        float sym_grad_beta = partialBeta[a][b] + partialBeta[b][a];
+        float correction = sym_grad_beta - (GammaBeta[a][b] + GammaBeta[b][a]);
+        grid_obj.at(F_K(a, b), i, j, k) = -0.5 / alpha * (cell.dgt[c] - correction);
     }
 }
@@ -36,17 +36,17 @@ void GridTensor::compute_partial_christoffel(Grid &grid_obj, int i, int j, int k
 
     if (dim == 0) {
         if (i == 0) { ip1 = i+1; im1 = i; }
-        else if (i == NX-1) { im1 = i-1; ip1 = i; }
+        else if (i == grid_obj.nx-1) { im1 = i-1; ip1 = i; }
         else { ip1 = i+1; im1 = i-1; }
     }
     if (dim == 1) {
         if (j == 0) { jp1 = j+1; jm1 = j; }
-        else if (j == NY-1) { jm1 = j-1; jp1 = j; }
+        else if (j == grid_obj.ny-1) { jm1 = j-1; jp1 = j; }
         else { jp1 = j+1; jm1 = j-1; }
     }
     if (dim == 2) {
         if (k == 0) { kp1 = k+1; km1 = k; }
-        else if (k == NZ-1) { km1 = k-1; kp1 = k; }
+        else if (k == grid_obj.nz-1) { km1 = k-1; kp1 = k; }
         else { kp1 = k+1; km1 = k-1; }
     }
 
@@ -86,9 +86,9 @@ void GridTensor::compute_ricci_3D_conformal(Grid &grid_obj, int i, int j, int k,
 
     float partialGamma[3][3][3][3] = {};
 	Log logger;
-    compute_partial_christoffel(grid_obj, i, j, k, 0, partialGamma, DX);
-    compute_partial_christoffel(grid_obj, i, j, k, 1, partialGamma, DY);
-    compute_partial_christoffel(grid_obj, i, j, k, 2, partialGamma, DZ);
+    compute_partial_christoffel(grid_obj, i, j, k, 0, partialGamma, grid_obj.dx);
+    compute_partial_christoffel(grid_obj, i, j, k, 1, partialGamma, grid_obj.dy);
+    compute_partial_christoffel(grid_obj, i, j, k, 2, partialGamma, grid_obj.dz);
 	
     for (int a = 0; a < 3; a++) {
         for (int b = 0; b < 3; b++) {
@@ -113,54 +113,47 @@ void GridTensor::compute_ricci_3D_conformal(Grid &grid_obj, int i, int j, int k,
 }
 
 
-void GridTensor::compute_ricci_conformal_factor(Grid &grid_obj, int i, int j, int k, float RicciChi[3][3]) {
+/*
+ * Ricci contribution of the conformal factor. d chi and dd chi come from
+ * the fused derivative pass at the stencil order of everything else.
+ * */
+void GridTensor::compute_ricci_conformal_factor(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float RicciChi[3][3]) {
     Grid::Cell2D &cell = grid_obj.getCell(i, j, k);
-    float chi = cell.chi;
+    float chi = grid_obj.at(F_CHI, i, j, k);
     float invChi = 1.0 / chi;
     float invChi2 = invChi * invChi;
 
     float dChi[3];
-    dChi[0] = (grid_obj.getCell(i+1,j,k).chi - grid_obj.getCell(i-1,j,k).chi) / (2.0 * DX);
-    dChi[1] = (grid_obj.getCell(i,j+1,k).chi - grid_obj.getCell(i,j-1,k).chi) / (2.0 * DY);
-    dChi[2] = (grid_obj.getCell(i,j,k+1).chi - grid_obj.getCell(i,j,k-1).chi) / (2.0 * DZ);
+    for (int m = 0; m < 3; ++m)
+        dChi[m] = pd.d(m, F_CHI);
+    const Sym3 &ddChi = pd.dd_chi;
 
-    float ddChi[3][3]; 
-    for (int a = 0; a < 3; ++a) {
-        for (int b = 0; b < 3; ++b) {
-            ddChi[a][b] = second_partial(grid_obj, i, j, k, a, b, [&](const Grid::Cell2D &c) {
-                return c.chi;
-            });
-        }
-    }
+    /* Δχ and |∇χ|^2 do not depend on (a, b) */
+    const float term1 = sym_contract(cell.geom.tildgamma_inv, ddChi);
+    float term2 = 0.0;
+    for (int m = 0; m < 3; ++m)
+        for (int n = 0; n < 3; ++n)
+            term2 += cell.geom.tildgamma_inv(m, n) * dChi[m] * dChi[n];
 
     for (int a = 0; a < 3; ++a) {
         for (int b = 0; b < 3; ++b) {
-            float term1 = 0.0, term2 = 0.0;
-            for (int m = 0; m < 3; ++m) {
-                for (int n = 0; n < 3; ++n) {
-                    term1 += cell.geom.tildgamma_inv[m][n] * ddChi[m][n]; // Δχ
-                    term2 += cell.geom.tildgamma_inv[m][n] * dChi[m] * dChi[n]; // |∇χ|^2
-                }
-            }
-
             RicciChi[a][b] =
-                0.5 * invChi * (ddChi[a][b] + cell.geom.tilde_gamma[a][b] * term1)
-              - 0.25 * invChi2 * (dChi[a] * dChi[b] + cell.geom.tilde_gamma[a][b] * term2);
+                0.5 * invChi * (ddChi(a, b) + grid_obj.at(F_GT(a, b), i, j, k) * term1)
+              - 0.25 * invChi2 * (dChi[a] * dChi[b] + grid_obj.at(F_GT(a, b), i, j, k) * term2);
         }
     }
 }
 
-void GridTensor::compute_ricci_BSSN(Grid &grid_obj, int i, int j, int k, float Ricci[3][3]) {
+void GridTensor::compute_ricci_BSSN(Grid &grid_obj, int i, int j, int k, const PointDerivatives &pd, float Ricci[3][3]) {
     float RicciTilde[3][3], RicciChi[3][3];
     compute_ricci_3D_conformal(grid_obj, i, j, k, RicciTilde);
-    compute_ricci_conformal_factor(grid_obj, i, j, k, RicciChi);
+    compute_ricci_conformal_factor(grid_obj, i, j, k, pd, RicciChi);
 
     for (int a = 0; a < 3; ++a)
         for (int b = 0; b < 3; ++b)
             Ricci[a][b] = RicciTilde[a][b] + RicciChi[a][b];
-	for (int a = 0; a < 3; a++) 
-		for (int b = 0; b < 3; b++) 
-			grid_obj.getCell(i, j, k).geom.Ricci[a][b] = Ricci[a][b];
+	for (int c = 0; c < SYM_NCOMP; c++) 
+		grid_obj.getCell(i, j, k).geom.Ricci[c] = Ricci[SYM_A[c]][SYM_B[c]];
 	/* #pragma omp critical */
 	/* { */
 	/* 	print_matrix_2D("Ricci", Ricci); */
@@ -1,11 +1,36 @@
 #include <Geodesics.h>
 
-int grid_setup() {
-    Grid grid_obj;
+/*
+ * N is the number of points per axis (NX_DEFAULT when N <= 0). The spacing is
+ * rescaled so the box keeps the same physical extent as the default grid.
+ * When a memory budget is set and the projected peak does not fit, N is
+ * lowered until it does; below GRID_MIN_N the run is refused.
+ */
+int grid_setup(int N) {
+    if (N <= 0)
+        N = NX_DEFAULT;
+    const size_t budget = MemoryBudget::budget();
+    if (budget && Grid::memory_plan(N, N, N, false) > budget) {
+        const int requested = N;
+        while (N > GRID_MIN_N && Grid::memory_plan(N, N, N, false) > budget)
+            N--;
+        if (Grid::memory_plan(N, N, N, false) > budget) {
+            Grid::memory_plan(requested, requested, requested, true);
+            fprintf(stderr, "Memory budget of %.2f MB too small for any grid >= %d^3, refusing to run\n",
+                    budget / (1024.0 * 1024.0), GRID_MIN_N);
+            return 1;
+        }
+        printf("Grid %d^3 exceeds the memory budget, downscaled to %d^3\n", requested, N);
+    }
+    Grid::memory_plan(N, N, N, true);
+
+    float h = DX_DEFAULT * NX_DEFAULT / N;
+    Grid grid_obj(N, N, N, h, h, h);
 	
 	grid_obj.allocateGlobalGrid();
 	grid_obj.initializeBinaryKerrData(grid_obj);
 	grid_obj.evolve(grid_obj, 0.0000001, 30);
+	MemoryBudget::report();
 	printf("end of compute\n");
     return 0;
 }
@@ -14,7 +14,7 @@ int main(int argc, char **argv)
 		printf("       -R <Spin value a> - Riemann tensor calculation\n");
 		printf("       -M <Spin value a> - Metric tensor calculation (a = 0 -> Schwarzschild or a > 0 -> Kerr)\n");
 		printf("       -S <Spin value a> - Black hole shadow generation\n");	
-		printf("       -C <Spin value a> - ADM solver Kerr-Schild coordinates (tests with flat Minkowski by replacing in probs)\n");
+		printf("       -C <Spin value a> <N> - ADM solver Kerr-Schild coordinates on an N^3 grid (tests with flat Minkowski by replacing in probs)\n");
 		return 0;
 	}
 
@@ -46,12 +46,12 @@ int main(int argc, char **argv)
 		Metric_prob();
 	} else if (strncmp(argv[1], "-C", 2) == 0) {
 		if (argc < 3) {
-			printf("Usage: -C <Spin value a>\n");
+			printf("Usage: -C <Spin value a> <N>\n");
 			printf("ADM solver Kerr-Schild coordinates\n");
 			printf("Metric: schwarzschild, kerr or Minkowski\n");
 			return 0;
 		}
-		grid_setup();
+		grid_setup(atoi(argv[3]));
 	}else {
 		printf("Invalid option\n");
 		return 0;